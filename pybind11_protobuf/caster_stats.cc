@@ -0,0 +1,32 @@
+// Copyright (c) 2023 The Pybind Development Team. All rights reserved.
+//
+// All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+// The pybind11_protobuf.caster_stats extension module, which queries the
+// conversion statistics of all extension modules using the casters. See
+// EnableCasterStats() in proto_cast_util.h.
+//
+//   from pybind11_protobuf import caster_stats
+//   caster_stats.enable()
+//   ...
+//   for full_name, stats in caster_stats.stats().items():
+//     print(full_name, stats['serialize'], stats['bytes'])
+
+#include <pybind11/pybind11.h>
+
+#include "pybind11_protobuf/proto_cast_util.h"
+
+namespace py = ::pybind11;
+
+PYBIND11_MODULE(caster_stats, m) {
+  m.def("enable", &pybind11_protobuf::EnableAllCasterStats,
+        py::arg("enabled") = true,
+        "Enables or disables recording conversion statistics, including for "
+        "extension modules initialized later.");
+  m.def("reset", &pybind11_protobuf::ResetAllCasterStats,
+        "Clears the recorded statistics.");
+  m.def("stats", &pybind11_protobuf::GetAllCasterStats,
+        "Returns the recorded statistics, as {full_name: {path: count, "
+        "'bytes': int, 'latency_us': [int]}}.");
+}
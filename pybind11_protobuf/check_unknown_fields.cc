@@ -1,6 +1,8 @@
 #include "pybind11_protobuf/check_unknown_fields.h"
 
+#include <atomic>
 #include <cassert>
+#include <cstddef>
 #include <cstdint>
 #include <optional>
 #include <string>
@@ -20,8 +22,18 @@ namespace pybind11_protobuf::check_unknown_fields {
 namespace {
 
 using AllowListSet = absl::flat_hash_set<std::string>;
-using MayContainExtensionsMap =
-    absl::flat_hash_map<const ::google::protobuf::Descriptor*, bool>;
+
+/// Per message type plan for the unknown field search.
+struct SearchPlan {
+  /// Whether the type, or any type reachable from it, declares an extension
+  /// range.
+  bool may_contain_extensions = false;
+  /// The declared message-typed fields whose type may contain extensions;
+  /// these are the only declared fields the search needs to visit.
+  std::vector<const ::google::protobuf::FieldDescriptor*> fields;
+};
+using SearchPlanMap =
+    absl::flat_hash_map<const ::google::protobuf::Descriptor*, SearchPlan>;
 
 AllowListSet* GetAllowList() {
   static auto* allow_list = new AllowListSet();
@@ -35,34 +47,88 @@ std::string MakeAllowListKey(
                       unknown_field_parent_message_fqn);
 }
 
-/// Recurses through the message Descriptor class looking for valid extensions.
-/// Stores the result to `memoized`.
-bool MessageMayContainExtensionsRecursive(const ::google::protobuf::Descriptor* descriptor,
-                                          MayContainExtensionsMap* memoized) {
-  if (descriptor->extension_range_count() > 0) return true;
-
-  auto [it, inserted] = memoized->try_emplace(descriptor, false);
-  if (!inserted) {
-    return it->second;
+/// Computes the SearchPlan for each message type reachable from `root`
+/// through message fields. Plans for every reachable type are added to
+/// `result`; entries already present are reused.
+void ComputeSearchPlans(const ::google::protobuf::Descriptor* root, SearchPlanMap* result) {
+  // Collect the types not yet in `result` which are reachable from root.
+  std::vector<const ::google::protobuf::Descriptor*> pending = {root};
+  absl::flat_hash_set<const ::google::protobuf::Descriptor*> seen = {root};
+  for (size_t i = 0; i < pending.size(); ++i) {
+    const auto* descriptor = pending[i];
+    for (int j = 0; j < descriptor->field_count(); j++) {
+      auto* fd = descriptor->field(j);
+      if (fd->cpp_type() != ::google::protobuf::FieldDescriptor::CPPTYPE_MESSAGE) continue;
+      const auto* type = fd->message_type();
+      if (result->contains(type) || !seen.insert(type).second) continue;
+      pending.push_back(type);
+    }
   }
 
-  for (int i = 0; i < descriptor->field_count(); i++) {
-    auto* fd = descriptor->field(i);
-    if (fd->cpp_type() != ::google::protobuf::FieldDescriptor::CPPTYPE_MESSAGE) continue;
-    if (MessageMayContainExtensionsRecursive(fd->message_type(), memoized)) {
-      (*memoized)[descriptor] = true;
-      return true;
+  // Propagate to a fixed point; this handles recursive message types, where
+  // a single memoized depth-first pass would record an answer for a type
+  // while one of its cycles was still being evaluated.
+  for (const auto* descriptor : pending) {
+    (*result)[descriptor].may_contain_extensions =
+        descriptor->extension_range_count() > 0;
+  }
+  auto may_contain_extensions = [&](const ::google::protobuf::FieldDescriptor* fd) {
+    if (fd->cpp_type() != ::google::protobuf::FieldDescriptor::CPPTYPE_MESSAGE) {
+      return false;
+    }
+    auto it = result->find(fd->message_type());
+    return it != result->end() && it->second.may_contain_extensions;
+  };
+  for (bool changed = true; changed;) {
+    changed = false;
+    for (const auto* descriptor : pending) {
+      SearchPlan& plan = (*result)[descriptor];
+      if (plan.may_contain_extensions) continue;
+      for (int j = 0; j < descriptor->field_count(); j++) {
+        if (may_contain_extensions(descriptor->field(j))) {
+          plan.may_contain_extensions = changed = true;
+          break;
+        }
+      }
     }
   }
 
-  return false;
+  for (const auto* descriptor : pending) {
+    SearchPlan& plan = (*result)[descriptor];
+    if (!plan.may_contain_extensions) continue;
+    for (int j = 0; j < descriptor->field_count(); j++) {
+      if (may_contain_extensions(descriptor->field(j))) {
+        plan.fields.push_back(descriptor->field(j));
+      }
+    }
+  }
 }
 
-bool MessageMayContainExtensionsMemoized(const ::google::protobuf::Descriptor* descriptor) {
-  static auto* memoized = new MayContainExtensionsMap();
+/// Returns the SearchPlan for a message type.
+///
+/// This is consulted on every C++ -> python cast, so the common path is a
+/// lock-free lookup into an immutable snapshot. A miss computes the plans
+/// for all types reachable from `descriptor` and publishes a new snapshot
+/// under a mutex. Replaced snapshots are leaked, as concurrent readers may
+/// still be using them; there is at most one per distinct uncached root type.
+const SearchPlan& GetSearchPlan(const ::google::protobuf::Descriptor* descriptor) {
+  static std::atomic<const SearchPlanMap*> snapshot{new SearchPlanMap()};
   static absl::Mutex lock;
+
+  const SearchPlanMap* current = snapshot.load(std::memory_order_acquire);
+  if (auto it = current->find(descriptor); it != current->end()) {
+    return it->second;
+  }
+
   absl::MutexLock l(&lock);
-  return MessageMayContainExtensionsRecursive(descriptor, memoized);
+  current = snapshot.load(std::memory_order_acquire);
+  if (auto it = current->find(descriptor); it != current->end()) {
+    return it->second;
+  }
+  auto* updated = new SearchPlanMap(*current);
+  ComputeSearchPlans(descriptor, updated);
+  snapshot.store(updated, std::memory_order_release);
+  return updated->at(descriptor);
 }
 
 struct HasUnknownFields {
@@ -70,81 +136,113 @@ struct HasUnknownFields {
                    const ::google::protobuf::Descriptor* root_descriptor)
       : py_proto_api(py_proto_api), root_descriptor(root_descriptor) {}
 
-  std::string FieldFQN() const { return absl::StrJoin(field_fqn_parts, "."); }
+  std::string FieldFQN() const {
+    return absl::StrJoin(field_path, ".",
+                         [](std::string* out, const auto* field) {
+                           absl::StrAppend(out, field->name());
+                         });
+  }
   std::string FieldFQNWithFieldNumber() const {
-    return field_fqn_parts.empty()
+    return field_path.empty()
                ? absl::StrCat(unknown_field_number)
                : absl::StrCat(FieldFQN(), ".", unknown_field_number);
   }
 
   bool FindUnknownFieldsRecursive(const ::google::protobuf::Message* sub_message,
                                   uint32_t depth);
+  bool FindUnknownFieldsInField(const ::google::protobuf::Message* sub_message,
+                                const ::google::protobuf::FieldDescriptor* field,
+                                uint32_t depth);
 
   std::string BuildErrorMessage() const;
 
   const ::google::protobuf::python::PyProto_API* py_proto_api;
   const ::google::protobuf::Descriptor* root_descriptor = nullptr;
   const ::google::protobuf::Descriptor* unknown_field_parent_descriptor = nullptr;
-  std::vector<std::string> field_fqn_parts;
+  // The path to the unknown field; only filled in once one is found.
+  std::vector<const ::google::protobuf::FieldDescriptor*> field_path;
   int unknown_field_number;
+  // Reused by each depth when listing the extensions of extendable messages.
+  std::vector<std::vector<const ::google::protobuf::FieldDescriptor*>> scratch;
 };
 
 /// Recurses through the message fields class looking for UnknownFields.
+/// Only fields in the SearchPlan, and extensions, are visited.
 bool HasUnknownFields::FindUnknownFieldsRecursive(
     const ::google::protobuf::Message* sub_message, uint32_t depth) {
-  const ::google::protobuf::Reflection& reflection = *sub_message->GetReflection();
-
-  // If there are unknown fields, stop searching.
-  const ::google::protobuf::UnknownFieldSet& unknown_field_set =
-      reflection.GetUnknownFields(*sub_message);
-  if (!unknown_field_set.empty()) {
-    unknown_field_parent_descriptor = sub_message->GetDescriptor();
-    unknown_field_number = unknown_field_set.field(0).number();
-
-    // Stop only if the extension is known by Python.
-    if (py_proto_api->GetDefaultDescriptorPool()->FindExtensionByNumber(
-            unknown_field_parent_descriptor,
-            unknown_field_number)) {
-      field_fqn_parts.resize(depth);
-      return true;
-    }
-  }
+  const ::google::protobuf::Descriptor* descriptor = sub_message->GetDescriptor();
+  const SearchPlan& plan = GetSearchPlan(descriptor);
 
   // If this message does not include submessages which allow extensions,
   // then it cannot include unknown fields.
-  if (!MessageMayContainExtensionsMemoized(sub_message->GetDescriptor())) {
+  if (!plan.may_contain_extensions) {
     return false;
   }
 
-  // Otherwise the method has to check all present fields, including
-  // extensions to determine if they include unknown fields.
-  std::vector<const ::google::protobuf::FieldDescriptor*> present_fields;
-  reflection.ListFields(*sub_message, &present_fields);
+  const ::google::protobuf::Reflection& reflection = *sub_message->GetReflection();
+  if (descriptor->extension_range_count() > 0) {
+    // If there are unknown fields, stop searching.
+    const ::google::protobuf::UnknownFieldSet& unknown_field_set =
+        reflection.GetUnknownFields(*sub_message);
+    if (!unknown_field_set.empty()) {
+      unknown_field_parent_descriptor = descriptor;
+      unknown_field_number = unknown_field_set.field(0).number();
 
-  for (const auto* field : present_fields) {
-    if (field->cpp_type() != ::google::protobuf::FieldDescriptor::CPPTYPE_MESSAGE) {
-      continue;
+      // Stop only if the extension is known by Python.
+      if (py_proto_api->GetDefaultDescriptorPool()->FindExtensionByNumber(
+              unknown_field_parent_descriptor, unknown_field_number)) {
+        field_path.resize(depth);
+        return true;
+      }
     }
-    if (field->is_repeated()) {
-      int field_size = reflection.FieldSize(*sub_message, field);
-      for (int i = 0; i != field_size; ++i) {
-        if (FindUnknownFieldsRecursive(
-                &reflection.GetRepeatedMessage(*sub_message, field, i),
-                depth + 1U)) {
-          field_fqn_parts[depth] = field->name();
-          return true;
-        }
+  }
+
+  for (const auto* field : plan.fields) {
+    if (FindUnknownFieldsInField(sub_message, field, depth)) return true;
+  }
+
+  // Extensions are not part of the plan, and the only way to enumerate the
+  // present ones is ListFields.
+  if (descriptor->extension_range_count() > 0) {
+    if (scratch.size() <= depth) scratch.resize(depth + 1);
+    scratch[depth].clear();
+    reflection.ListFields(*sub_message, &scratch[depth]);
+    for (size_t i = 0; i < scratch[depth].size(); ++i) {
+      const auto* field = scratch[depth][i];
+      if (!field->is_extension() ||
+          field->cpp_type() != ::google::protobuf::FieldDescriptor::CPPTYPE_MESSAGE) {
+        continue;
       }
-    } else if (FindUnknownFieldsRecursive(
-                   &reflection.GetMessage(*sub_message, field), depth + 1U)) {
-      field_fqn_parts[depth] = field->name();
-      return true;
+      if (FindUnknownFieldsInField(sub_message, field, depth)) return true;
     }
   }
 
   return false;
 }
 
+bool HasUnknownFields::FindUnknownFieldsInField(
+    const ::google::protobuf::Message* sub_message, const ::google::protobuf::FieldDescriptor* field,
+    uint32_t depth) {
+  const ::google::protobuf::Reflection& reflection = *sub_message->GetReflection();
+  if (field->is_repeated()) {
+    int field_size = reflection.FieldSize(*sub_message, field);
+    for (int i = 0; i != field_size; ++i) {
+      if (FindUnknownFieldsRecursive(
+              &reflection.GetRepeatedMessage(*sub_message, field, i),
+              depth + 1U)) {
+        field_path[depth] = field;
+        return true;
+      }
+    }
+  } else if (reflection.HasField(*sub_message, field) &&
+             FindUnknownFieldsRecursive(
+                 &reflection.GetMessage(*sub_message, field), depth + 1U)) {
+    field_path[depth] = field;
+    return true;
+  }
+  return false;
+}
+
 std::string HasUnknownFields::BuildErrorMessage() const {
   assert(unknown_field_parent_descriptor != nullptr);
   assert(root_descriptor != nullptr);
@@ -185,6 +283,11 @@ std::optional<std::string> CheckAndBuildErrorMessageIfAny(
     const ::google::protobuf::python::PyProto_API* py_proto_api,
     const ::google::protobuf::Message* message) {
   const auto* root_descriptor = message->GetDescriptor();
+  // Unknown fields are only reported when they are extensions known to
+  // python, which requires an extendable type somewhere in the message.
+  if (!GetSearchPlan(root_descriptor).may_contain_extensions) {
+    return std::nullopt;
+  }
   HasUnknownFields search{py_proto_api, root_descriptor};
   if (!search.FindUnknownFieldsRecursive(message, 0u)) {
     return std::nullopt;
@@ -0,0 +1,17 @@
+// Copyright (c) 2023 The Pybind Development Team. All rights reserved.
+//
+// All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+// The pybind11_protobuf.delimited_io extension module, which reads and writes
+// length-delimited message streams. See delimited_message_io.h.
+
+#include <pybind11/pybind11.h>
+
+#include "pybind11_protobuf/delimited_message_io.h"
+#include "pybind11_protobuf/native_proto_caster.h"
+
+PYBIND11_MODULE(delimited_io, m) {
+  pybind11_protobuf::ImportNativeProtoCasters();
+  pybind11_protobuf::RegisterDelimitedMessageIO(m);
+}
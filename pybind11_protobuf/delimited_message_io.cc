@@ -0,0 +1,822 @@
+// Copyright (c) 2023 The Pybind Development Team. All rights reserved.
+//
+// All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include "pybind11_protobuf/delimited_message_io.h"
+
+#include <Python.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/pytypes.h>
+
+#include <algorithm>
+#include <cassert>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/io/zero_copy_stream.h"
+#include "google/protobuf/io/zero_copy_stream_impl.h"
+#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
+#include "google/protobuf/message.h"
+#include "google/protobuf/message_lite.h"
+#include "google/protobuf/util/delimited_message_util.h"
+#include "google/protobuf/wire_format_lite.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+#include "pybind11_protobuf/proto_cast_util.h"
+#include "pybind11_protobuf/proto_view.h"
+
+namespace py = pybind11;
+
+namespace pybind11_protobuf {
+namespace {
+
+using ::google::protobuf::Descriptor;
+using ::google::protobuf::DescriptorPool;
+using ::google::protobuf::FieldDescriptor;
+using ::google::protobuf::Message;
+using ::google::protobuf::MessageFactory;
+using ::google::protobuf::MessageLite;
+using ::google::protobuf::io::CodedInputStream;
+using ::google::protobuf::io::CodedOutputStream;
+using ::google::protobuf::io::ZeroCopyInputStream;
+
+// A ZeroCopyInputStream over a contiguous buffer, which unlike ArrayInputStream
+// may be larger than 2GiB.
+class LargeArrayInputStream : public ZeroCopyInputStream {
+ public:
+  LargeArrayInputStream(const char* data, size_t size)
+      : data_(data), size_(size) {}
+
+  bool Next(const void** data, int* size) override {
+    if (position_ == size_) return false;
+    size_t block = std::min(size_ - position_, kMaxBlockSize);
+    *data = data_ + position_;
+    *size = static_cast<int>(block);
+    position_ += block;
+    return true;
+  }
+  void BackUp(int count) override { position_ -= count; }
+  bool Skip(int count) override {
+    size_t skipped = std::min(size_ - position_, static_cast<size_t>(count));
+    position_ += skipped;
+    return skipped == static_cast<size_t>(count);
+  }
+  int64_t ByteCount() const override {
+    return static_cast<int64_t>(position_);
+  }
+
+ private:
+  static constexpr size_t kMaxBlockSize = 1 << 30;
+
+  const char* data_;
+  size_t size_;
+  size_t position_ = 0;
+};
+
+// Converts the python error raised by a file object into a stored
+// error_already_set, so that it does not propagate through protobuf code.
+class PyErrorHolder {
+ public:
+  void Store(py::error_already_set& e) {
+    error_ = std::make_unique<py::error_already_set>(std::move(e));
+  }
+  void Store(PyObject* type, const std::string& message) {
+    PyErr_SetString(type, message.c_str());
+    error_ = std::make_unique<py::error_already_set>();
+  }
+  void RethrowIfAny() {
+    if (!error_) return;
+    py::error_already_set error = std::move(*error_);
+    error_.reset();
+    throw error;
+  }
+
+ private:
+  std::unique_ptr<py::error_already_set> error_;
+};
+
+// Holds a contiguous buffer of a python object, such as bytes or mmap.mmap,
+// which may then be read without the GIL.
+class PyBufferView {
+ public:
+  explicit PyBufferView(py::handle source) {
+    if (PyObject_GetBuffer(source.ptr(), &view_, PyBUF_SIMPLE) != 0) {
+      throw py::error_already_set();
+    }
+  }
+  ~PyBufferView() { PyBuffer_Release(&view_); }
+
+  PyBufferView(const PyBufferView&) = delete;
+  PyBufferView& operator=(const PyBufferView&) = delete;
+
+  const char* data() const { return static_cast<const char*>(view_.buf); }
+  size_t size() const { return static_cast<size_t>(view_.len); }
+
+ private:
+  Py_buffer view_;
+};
+
+std::string TypeName(py::handle obj) {
+  return std::string(py::str(py::type::handle_of(obj).attr("__name__")));
+}
+
+}  // namespace
+
+struct DelimitedInputSource::Buffer : PyBufferView {
+  using PyBufferView::PyBufferView;
+};
+
+class DelimitedInputSource::PyFileInputStream
+    : public ::google::protobuf::io::CopyingInputStream {
+ public:
+  explicit PyFileInputStream(py::object read) : read_(std::move(read)) {}
+
+  int Read(void* buffer, int size) override {
+    try {
+      py::object data = read_(size);
+      if (!PyBytes_Check(data.ptr())) {
+        error_.Store(PyExc_TypeError,
+                     "read() returned " + TypeName(data) +
+                         ", expected bytes; is the file opened in binary "
+                         "mode?");
+        return -1;
+      }
+      Py_ssize_t length = PyBytes_GET_SIZE(data.ptr());
+      if (length > size) {
+        error_.Store(PyExc_ValueError, "read() returned too many bytes");
+        return -1;
+      }
+      std::memcpy(buffer, PyBytes_AS_STRING(data.ptr()), length);
+      return static_cast<int>(length);
+    } catch (py::error_already_set& e) {
+      error_.Store(e);
+      return -1;
+    }
+  }
+
+  void RethrowError() { error_.RethrowIfAny(); }
+
+ private:
+  py::object read_;
+  PyErrorHolder error_;
+};
+
+DelimitedInputSource::DelimitedInputSource(py::handle source)
+    : source_(py::reinterpret_borrow<py::object>(source)) {
+  assert(PyGILState_Check());
+  if (PyObject_CheckBuffer(source.ptr())) {
+    buffer_ = std::make_unique<Buffer>(source);
+    stream_ = std::make_unique<LargeArrayInputStream>(
+        buffer_->data(), buffer_->size());
+  } else if (PyLong_Check(source.ptr())) {
+    stream_ = std::make_unique<::google::protobuf::io::FileInputStream>(
+        source.cast<int>());
+  } else if (py::hasattr(source, "read")) {
+    file_ = std::make_unique<PyFileInputStream>(source.attr("read"));
+    stream_ =
+        std::make_unique<::google::protobuf::io::CopyingInputStreamAdaptor>(
+            file_.get());
+    requires_gil_ = true;
+  } else {
+    throw py::type_error(
+        "Expected a buffer, a file descriptor or a binary file object, got " +
+        TypeName(source));
+  }
+}
+
+DelimitedInputSource::~DelimitedInputSource() = default;
+
+bool DelimitedInputSource::ReadMessage(MessageLite* message) {
+  // ParseDelimitedFromZeroCopyStream merges, and callers reuse messages.
+  message->Clear();
+  bool clean_eof = false;
+  if (::google::protobuf::util::ParseDelimitedFromZeroCopyStream(
+          message, stream_.get(), &clean_eof)) {
+    return true;
+  }
+  return HandleReadFailure(clean_eof, std::string(message->GetTypeName()));
+}
+
+bool DelimitedInputSource::ReadRecord(std::string* record) {
+  CodedInputStream input(stream_.get());
+  const int start = input.CurrentPosition();
+  uint32_t size;
+  if (!input.ReadVarint32(&size)) {
+    return HandleReadFailure(input.CurrentPosition() == start, "message");
+  }
+  if (!input.ReadString(record, static_cast<int>(size))) {
+    return HandleReadFailure(false, "message");
+  }
+  return true;
+}
+
+bool DelimitedInputSource::HandleReadFailure(bool clean_eof,
+                                             const std::string& type_name) {
+  if (file_) file_->RethrowError();
+  if (clean_eof) return false;
+  throw py::value_error("Truncated or malformed " + type_name +
+                        " in length-delimited stream");
+}
+
+class DelimitedOutputSink::PyFileOutputStream
+    : public ::google::protobuf::io::CopyingOutputStream {
+ public:
+  explicit PyFileOutputStream(py::object write) : write_(std::move(write)) {}
+
+  bool Write(const void* buffer, int size) override {
+    const char* data = static_cast<const char*>(buffer);
+    try {
+      // Raw (unbuffered) files may write fewer bytes than requested.
+      while (size > 0) {
+        py::object written = write_(py::bytes(data, size));
+        if (written.is_none()) break;
+        int count = written.cast<int>();
+        if (count <= 0) {
+          error_.Store(PyExc_OSError, "write() made no progress");
+          return false;
+        }
+        data += count;
+        size -= count;
+      }
+      return true;
+    } catch (py::error_already_set& e) {
+      error_.Store(e);
+      return false;
+    }
+  }
+
+  void RethrowError() { error_.RethrowIfAny(); }
+
+ private:
+  py::object write_;
+  PyErrorHolder error_;
+};
+
+DelimitedOutputSink::DelimitedOutputSink(py::handle sink)
+    : sink_(py::reinterpret_borrow<py::object>(sink)) {
+  assert(PyGILState_Check());
+  if (PyLong_Check(sink.ptr())) {
+    fd_stream_ = std::make_unique<::google::protobuf::io::FileOutputStream>(
+        sink.cast<int>());
+  } else if (py::hasattr(sink, "write")) {
+    file_ = std::make_unique<PyFileOutputStream>(sink.attr("write"));
+    file_stream_ =
+        std::make_unique<::google::protobuf::io::CopyingOutputStreamAdaptor>(
+            file_.get());
+    requires_gil_ = true;
+  } else {
+    throw py::type_error(
+        "Expected a file descriptor or a binary file object, got " +
+        TypeName(sink));
+  }
+}
+
+// The stream destructors flush any buffered output, ignoring errors.
+DelimitedOutputSink::~DelimitedOutputSink() = default;
+
+::google::protobuf::io::ZeroCopyOutputStream* DelimitedOutputSink::stream() {
+  if (fd_stream_) return fd_stream_.get();
+  return file_stream_.get();
+}
+
+void DelimitedOutputSink::WriteMessage(const MessageLite& message) {
+  if (!message.IsInitialized()) {
+    throw py::value_error("Message " + std::string(message.GetTypeName()) +
+                          " is missing required fields: " +
+                          message.InitializationErrorString());
+  }
+  CheckWriteError(::google::protobuf::util::SerializeDelimitedToZeroCopyStream(
+      message, stream()));
+}
+
+void DelimitedOutputSink::WriteRecord(absl::string_view record) {
+  if (record.size() > static_cast<size_t>(INT_MAX)) {
+    throw py::value_error("Message too large for a length-delimited stream");
+  }
+  bool ok;
+  {
+    CodedOutputStream output(stream());
+    output.WriteVarint32(static_cast<uint32_t>(record.size()));
+    output.WriteRaw(record.data(), static_cast<int>(record.size()));
+    ok = !output.HadError();
+  }
+  CheckWriteError(ok);
+}
+
+void DelimitedOutputSink::Flush() {
+  CheckWriteError(fd_stream_ ? fd_stream_->Flush() : file_stream_->Flush());
+}
+
+void DelimitedOutputSink::CheckWriteError(bool ok) {
+  if (file_) file_->RethrowError();
+  if (ok) return;
+  if (fd_stream_) {
+    PyErr_SetFromErrno(PyExc_OSError);
+    throw py::error_already_set();
+  }
+  throw py::value_error("Failed to write length-delimited stream");
+}
+
+namespace {
+
+constexpr char kClosedError[] = "I/O operation on closed stream.";
+
+// The number of messages shown by the repr of a LazyMessageSequence.
+constexpr size_t kReprElements = 10;
+
+// The C++ prototype for messages of a python message class, when the type is
+// compiled into this extension module. Only classes of the default python
+// pool (or of no pool, in old generated code) are matched: a class of another
+// pool may share the full name of a compiled-in type, but the caster would
+// return instances of the default pool class for it.
+const Message* GeneratedPrototype(py::handle message_type) {
+  if (!py::hasattr(message_type, "DESCRIPTOR")) {
+    throw py::type_error("Expected a protobuf message class, got " +
+                         std::string(py::repr(message_type)));
+  }
+  py::object py_descriptor = message_type.attr("DESCRIPTOR");
+  py::object pool = py_descriptor.attr("file").attr("pool");
+  if (!pool.is_none() &&
+      !pool.is(py::module_::import("google.protobuf.descriptor_pool")
+                   .attr("Default")())) {
+    return nullptr;
+  }
+  auto full_name = py_descriptor.attr("full_name").cast<std::string>();
+  const Descriptor* descriptor =
+      DescriptorPool::generated_pool()->FindMessageTypeByName(full_name);
+  if (descriptor == nullptr) return nullptr;
+  return MessageFactory::generated_factory()->GetPrototype(descriptor);
+}
+
+// Reads python messages of one type, in chunks. Types compiled into this
+// module are parsed in C++, with the GIL released unless the source is a
+// python file object, and converted by GenericProtoListCast. Other types
+// are read as bytes and parsed by message_type.FromString().
+class DelimitedMessageReader {
+ public:
+  DelimitedMessageReader(py::handle source, py::handle message_type,
+                         size_t chunk_size)
+      : chunk_size_(chunk_size) {
+    if (chunk_size_ == 0) throw py::value_error("chunk_size must be positive");
+    prototype_ = GeneratedPrototype(message_type);
+    if (prototype_ == nullptr) {
+      from_string_ = message_type.attr("FromString");
+    }
+    input_ = std::make_unique<DelimitedInputSource>(source);
+  }
+
+  // Returns up to max_count messages, or all remaining ones when negative;
+  // an empty list at the end of the stream. When a record is malformed, the
+  // messages before it are returned and the error is raised by the next call.
+  py::list Read(py::ssize_t max_count) {
+    py::list result;
+    size_t remaining =
+        max_count < 0 ? SIZE_MAX : static_cast<size_t>(max_count);
+    while (remaining > 0) {
+      size_t count = std::min(remaining, chunk_size_);
+      size_t read = ReadChunk(count, result);
+      if (read < count) break;
+      remaining -= read;
+    }
+    return result;
+  }
+
+  py::object Next() {
+    if (pending_index_ == pending_.size()) {
+      pending_ = py::list();
+      pending_index_ = 0;
+      if (ReadChunk(chunk_size_, pending_) == 0) throw py::stop_iteration();
+    }
+    return pending_[pending_index_++];
+  }
+
+  void Close() { input_.reset(); }
+
+ private:
+  // Appends up to `count` messages to `result`, returning how many.
+  size_t ReadChunk(size_t count, py::list& result) {
+    if (!input_) throw py::value_error(kClosedError);
+    if (error_) std::rethrow_exception(std::exchange(error_, nullptr));
+    if (prototype_ != nullptr) return ReadMessages(count, result);
+    return ReadRecords(count, result);
+  }
+
+  size_t ReadMessages(size_t count, py::list& result) {
+    while (messages_.size() < count) {
+      messages_.emplace_back(prototype_->New());
+      pointers_.push_back(messages_.back().get());
+    }
+    size_t read = 0;
+    {
+      absl::optional<py::gil_scoped_release> release;
+      if (!input_->requires_gil()) release.emplace();
+      try {
+        while (read < count && input_->ReadMessage(messages_[read].get())) {
+          ++read;
+        }
+      } catch (...) {
+        if (read == 0) throw;
+        error_ = std::current_exception();
+      }
+    }
+    if (read == 0) return 0;
+    // The messages are moved into python, leaving them empty for reuse.
+    auto chunk = py::reinterpret_steal<py::list>(GenericProtoListCast(
+        prototype_->GetDescriptor(), pointers_.data(), read, /*move=*/true));
+    if (!chunk) throw py::error_already_set();
+    if (result.empty()) {
+      result = std::move(chunk);
+    } else {
+      for (py::handle message : chunk) result.append(message);
+    }
+    return read;
+  }
+
+  size_t ReadRecords(size_t count, py::list& result) {
+    if (records_.size() < count) records_.resize(count);
+    size_t read = 0;
+    {
+      absl::optional<py::gil_scoped_release> release;
+      if (!input_->requires_gil()) release.emplace();
+      try {
+        while (read < count && input_->ReadRecord(&records_[read])) ++read;
+      } catch (...) {
+        if (read == 0) throw;
+        error_ = std::current_exception();
+      }
+    }
+    for (size_t i = 0; i < read; ++i) {
+      result.append(from_string_(py::bytes(records_[i])));
+    }
+    return read;
+  }
+
+  const size_t chunk_size_;
+  const Message* prototype_ = nullptr;
+  py::object from_string_;
+  std::unique_ptr<DelimitedInputSource> input_;
+  std::vector<std::unique_ptr<Message>> messages_;
+  std::vector<Message*> pointers_;
+  std::vector<std::string> records_;
+  py::list pending_;
+  size_t pending_index_ = 0;
+  // The read error which followed the messages last returned.
+  std::exception_ptr error_;
+};
+
+// Writes python messages. Messages backed by a compatible C++ message, and
+// read-only views, are serialized in C++; others by SerializeToString().
+class DelimitedMessageWriter {
+ public:
+  explicit DelimitedMessageWriter(py::handle sink)
+      : output_(std::make_unique<DelimitedOutputSink>(sink)) {}
+
+  void Write(py::handle message) {
+    if (!output_) throw py::value_error(kClosedError);
+    const Message* cpp_message = PyProtoGetCppMessagePointer(message);
+    if (cpp_message == nullptr) {
+      cpp_message = PyProtoViewGetCppMessagePointer(message);
+    }
+    if (cpp_message != nullptr) {
+      output_->WriteMessage(*cpp_message);
+      return;
+    }
+    py::object wire = message.attr("SerializeToString")();
+    output_->WriteRecord(absl::string_view(PYBIND11_BYTES_AS_STRING(wire.ptr()),
+                                           PYBIND11_BYTES_SIZE(wire.ptr())));
+  }
+
+  void WriteAll(py::iterable messages) {
+    for (py::handle message : messages) Write(message);
+  }
+
+  void Flush() {
+    if (!output_) throw py::value_error(kClosedError);
+    output_->Flush();
+  }
+
+  void Close() {
+    if (!output_) return;
+    output_->Flush();
+    output_.reset();
+  }
+
+ private:
+  std::unique_ptr<DelimitedOutputSink> output_;
+};
+
+// Decodes the varint at data[*pos], advancing *pos past it. Returns false if
+// the varint is truncated or longer than 10 bytes.
+bool ReadVarint(const char* data, size_t size, size_t* pos, uint64_t* value) {
+  uint64_t result = 0;
+  for (int shift = 0; shift < 64 && *pos < size; shift += 7) {
+    uint8_t byte = static_cast<uint8_t>(data[(*pos)++]);
+    result |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0) {
+      *value = result;
+      return true;
+    }
+  }
+  return false;
+}
+
+// A read-only python sequence of the messages in a buffer, which is indexed
+// once on construction: the index holds the offset of each element's length
+// prefix, and elements are only parsed by __getitem__. Suitable for mmaps of
+// files too large to parse, or hold as python messages, at once.
+//
+// Indexing, slicing and repr follow RepeatedFieldContainer in
+// proto_utils.cc.
+class LazyMessageSequence {
+ public:
+  // Indexes a length-delimited stream of message_type.
+  static std::unique_ptr<LazyMessageSequence> FromDelimited(
+      py::handle buffer, py::handle message_type) {
+    std::unique_ptr<LazyMessageSequence> sequence(
+        new LazyMessageSequence(buffer, message_type));
+    py::gil_scoped_release release;
+    sequence->IndexDelimited();
+    return sequence;
+  }
+
+  // Indexes the elements of `field_name`, a repeated message field, in a
+  // serialized message of parent_type.
+  static std::unique_ptr<LazyMessageSequence> FromRepeatedField(
+      py::handle buffer, py::handle parent_type,
+      const std::string& field_name) {
+    py::object descriptor = parent_type.attr("DESCRIPTOR");
+    py::object fields = descriptor.attr("fields_by_name");
+    if (!fields.contains(field_name)) {
+      throw py::value_error(descriptor.attr("full_name").cast<std::string>() +
+                            " has no field " + field_name);
+    }
+    py::object field = fields[py::str(field_name)];
+    if (field.attr("message_type").is_none() ||
+        field.attr("label").cast<int>() != FieldDescriptor::LABEL_REPEATED) {
+      throw py::value_error(field_name + " is not a repeated message field");
+    }
+    py::object element_type =
+        py::module_::import("google.protobuf.message_factory")
+            .attr("GetMessageClass")(field.attr("message_type"));
+    std::unique_ptr<LazyMessageSequence> sequence(
+        new LazyMessageSequence(buffer, element_type));
+    const uint32_t number = field.attr("number").cast<uint32_t>();
+    py::gil_scoped_release release;
+    sequence->IndexRepeatedField(number);
+    return sequence;
+  }
+
+  py::ssize_t Size() const {
+    return static_cast<py::ssize_t>(offsets_.size());
+  }
+
+  py::object GetItem(py::ssize_t idx) const {
+    size_t offset = offsets_[CheckIndex(idx)];
+    if (prototype_ == nullptr) return from_string_(ElementBytes(offset));
+    std::unique_ptr<Message> message(prototype_->New());
+    Parse(offset, message.get());
+    return py::reinterpret_steal<py::object>(
+        GenericProtoCast(message.get(), py::return_value_policy::move,
+                         py::handle(), false));
+  }
+
+  py::list GetSlice(py::slice slice) const {
+    size_t start, stop, step, slice_length;
+    if (!slice.compute(offsets_.size(), &start, &stop, &step, &slice_length))
+      throw py::error_already_set();
+    if (prototype_ == nullptr) {
+      py::list seq;
+      for (size_t i = 0; i < slice_length; ++i) {
+        seq.append(from_string_(ElementBytes(offsets_[start])));
+        start += step;
+      }
+      return seq;
+    }
+    // Parse the slice with the GIL released, then convert it in one batch.
+    std::vector<std::unique_ptr<Message>> messages(slice_length);
+    std::vector<Message*> pointers(slice_length);
+    {
+      py::gil_scoped_release release;
+      for (size_t i = 0; i < slice_length; ++i) {
+        messages[i].reset(prototype_->New());
+        pointers[i] = messages[i].get();
+        Parse(offsets_[start], pointers[i]);
+        start += step;
+      }
+    }
+    auto seq = py::reinterpret_steal<py::list>(
+        GenericProtoListCast(prototype_->GetDescriptor(), pointers.data(),
+                             slice_length, /*move=*/true));
+    if (!seq) throw py::error_already_set();
+    return seq;
+  }
+
+  // Shows the first kReprElements messages, so that the repr of a large
+  // sequence does not parse all of it.
+  std::string Repr() const {
+    if (offsets_.empty()) return "[]";
+    const size_t shown = std::min(offsets_.size(), kReprElements);
+    std::string repr = "[";
+    for (size_t i = 0; i < shown; ++i) {
+      repr += ElementRepr(offsets_[i]) + ", ";
+    }
+    if (shown < offsets_.size()) {
+      repr += "..., " + std::to_string(offsets_.size() - shown) + " more]";
+      return repr;
+    }
+    repr.pop_back();
+    repr.back() = ']';
+    return repr;
+  }
+
+ private:
+  LazyMessageSequence(py::handle buffer, py::handle message_type)
+      : source_(py::reinterpret_borrow<py::object>(buffer)),
+        buffer_(buffer),
+        prototype_(GeneratedPrototype(message_type)) {
+    if (prototype_ == nullptr) {
+      from_string_ = message_type.attr("FromString");
+    }
+  }
+
+  void IndexDelimited() {
+    const char* data = buffer_.data();
+    const size_t size = buffer_.size();
+    size_t pos = 0;
+    while (pos < size) {
+      size_t offset = pos;
+      SkipLengthDelimited(data, size, &pos);
+      offsets_.push_back(offset);
+    }
+    offsets_.shrink_to_fit();
+  }
+
+  void IndexRepeatedField(uint32_t number) {
+    using ::google::protobuf::internal::WireFormatLite;
+    const char* data = buffer_.data();
+    const size_t size = buffer_.size();
+    size_t pos = 0;
+    while (pos < size) {
+      uint64_t tag;
+      if (!ReadVarint(data, size, &pos, &tag)) ThrowTruncated();
+      switch (WireFormatLite::GetTagWireType(static_cast<uint32_t>(tag))) {
+        case WireFormatLite::WIRETYPE_VARINT: {
+          uint64_t ignored;
+          if (!ReadVarint(data, size, &pos, &ignored)) ThrowTruncated();
+          break;
+        }
+        case WireFormatLite::WIRETYPE_FIXED64:
+          pos += 8;
+          break;
+        case WireFormatLite::WIRETYPE_FIXED32:
+          pos += 4;
+          break;
+        case WireFormatLite::WIRETYPE_LENGTH_DELIMITED: {
+          size_t offset = pos;
+          SkipLengthDelimited(data, size, &pos);
+          if (WireFormatLite::GetTagFieldNumber(static_cast<uint32_t>(tag)) ==
+              static_cast<int>(number)) {
+            offsets_.push_back(offset);
+          }
+          break;
+        }
+        default:
+          throw py::value_error(
+              "Unsupported wire type (groups are not supported) at offset " +
+              std::to_string(pos));
+      }
+      if (pos > size) ThrowTruncated();
+    }
+    offsets_.shrink_to_fit();
+  }
+
+  static void SkipLengthDelimited(const char* data, size_t size,
+                                  size_t* pos) {
+    uint64_t length;
+    if (!ReadVarint(data, size, pos, &length) || length > size - *pos) {
+      ThrowTruncated();
+    }
+    *pos += length;
+  }
+
+  [[noreturn]] static void ThrowTruncated() {
+    throw py::value_error("Truncated or malformed length-delimited data");
+  }
+
+  // Returns the serialized element which has its length prefix at `offset`.
+  absl::string_view Element(size_t offset) const {
+    uint64_t length;
+    ReadVarint(buffer_.data(), buffer_.size(), &offset, &length);
+    return absl::string_view(buffer_.data() + offset, length);
+  }
+
+  py::bytes ElementBytes(size_t offset) const {
+    absl::string_view element = Element(offset);
+    return py::bytes(element.data(), element.size());
+  }
+
+  void Parse(size_t offset, Message* message) const {
+    absl::string_view element = Element(offset);
+    if (element.size() > static_cast<size_t>(INT_MAX) ||
+        !message->ParseFromArray(element.data(),
+                                 static_cast<int>(element.size()))) {
+      throw py::value_error("Error parsing message of type " +
+                            message->GetDescriptor()->full_name());
+    }
+  }
+
+  std::string ElementRepr(size_t offset) const {
+    if (prototype_ == nullptr) {
+      return py::module_::import("google.protobuf.text_format")
+          .attr("MessageToString")(from_string_(ElementBytes(offset)),
+                                   py::arg("as_one_line") = true)
+          .cast<std::string>();
+    }
+    std::unique_ptr<Message> message(prototype_->New());
+    Parse(offset, message.get());
+    return message->ShortDebugString();
+  }
+
+  // Throws an exception if the index is bad, adjusting for negative indexes
+  // (which are relative to the end of the list). Returns the adjusted index.
+  size_t CheckIndex(py::ssize_t idx) const {
+    py::ssize_t size = Size();
+    if (idx < 0) idx += size;  // Negative numbers index from the end.
+    if (idx < 0 || idx >= size) {
+      PyErr_SetString(PyExc_IndexError, "list index out of range");
+      throw py::error_already_set();
+    }
+    return static_cast<size_t>(idx);
+  }
+
+  py::object source_;
+  PyBufferView buffer_;
+  const Message* prototype_;
+  py::object from_string_;
+  std::vector<uint64_t> offsets_;
+};
+
+}  // namespace
+
+void RegisterDelimitedMessageIO(py::module_ m) {
+  InitializePybindProtoCastUtil();
+
+  py::class_<DelimitedMessageReader>(
+      m, "DelimitedMessageReader", py::module_local(),
+      "Reads varint length-delimited messages of message_type from a buffer "
+      "(bytes, memoryview, mmap), a file descriptor or a binary file object.")
+      .def(py::init<py::handle, py::handle, size_t>(), py::arg("source"),
+           py::arg("message_type"), py::arg("chunk_size") = 1024)
+      .def("read", &DelimitedMessageReader::Read, py::arg("max_count") = -1,
+           "Returns up to max_count messages, all remaining messages when "
+           "negative, and an empty list at the end of the stream. The "
+           "messages before a malformed record are returned, and the next "
+           "call raises the error.")
+      .def("__iter__", [](py::object self) { return self; })
+      .def("__next__", &DelimitedMessageReader::Next)
+      .def("close", &DelimitedMessageReader::Close)
+      .def("__enter__", [](py::object self) { return self; })
+      .def("__exit__",
+           [](DelimitedMessageReader& self, py::args) { self.Close(); });
+
+  py::class_<LazyMessageSequence>(
+      m, "LazyMessageSequence", py::module_local(),
+      "A read-only sequence of messages in a buffer, such as bytes or an "
+      "mmap, which are parsed on access. The buffer is held, so an mmap "
+      "cannot be closed while the sequence is alive.")
+      .def(py::init(&LazyMessageSequence::FromDelimited), py::arg("buffer"),
+           py::arg("message_type"))
+      .def_static("from_repeated_field",
+                  &LazyMessageSequence::FromRepeatedField, py::arg("buffer"),
+                  py::arg("parent_type"), py::arg("field_name"),
+                  "Indexes the elements of a repeated message field in a "
+                  "serialized parent_type message.")
+      .def("__len__", &LazyMessageSequence::Size)
+      .def("__getitem__", &LazyMessageSequence::GetItem)
+      .def("__getitem__", &LazyMessageSequence::GetSlice)
+      .def("__repr__", &LazyMessageSequence::Repr);
+
+  py::class_<DelimitedMessageWriter>(
+      m, "DelimitedMessageWriter", py::module_local(),
+      "Writes varint length-delimited messages to a file descriptor or a "
+      "binary file object. Output is buffered until flush() or close().")
+      .def(py::init<py::handle>(), py::arg("sink"))
+      .def("write", &DelimitedMessageWriter::Write, py::arg("message"))
+      .def("write_all", &DelimitedMessageWriter::WriteAll, py::arg("messages"))
+      .def("flush", &DelimitedMessageWriter::Flush)
+      .def("close", &DelimitedMessageWriter::Close)
+      .def("__enter__", [](py::object self) { return self; })
+      .def("__exit__",
+           [](DelimitedMessageWriter& self, py::args) { self.Close(); });
+}
+
+}  // namespace pybind11_protobuf
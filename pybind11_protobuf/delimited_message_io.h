@@ -0,0 +1,156 @@
+// Copyright (c) 2023 The Pybind Development Team. All rights reserved.
+//
+// All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#ifndef PYBIND11_PROTOBUF_DELIMITED_MESSAGE_IO_H_
+#define PYBIND11_PROTOBUF_DELIMITED_MESSAGE_IO_H_
+
+#include <pybind11/pybind11.h>
+#include <pybind11/pytypes.h>
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "google/protobuf/io/zero_copy_stream.h"
+#include "google/protobuf/io/zero_copy_stream_impl.h"
+#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
+#include "google/protobuf/message_lite.h"
+#include "absl/strings/string_view.h"
+
+// Readers and writers of varint length-delimited message streams, in the
+// format of google/protobuf/util/delimited_message_util.h, over python
+// buffers, file descriptors and file objects.
+//
+// From python, RegisterDelimitedMessageIO() adds DelimitedMessageReader,
+// DelimitedMessageWriter and LazyMessageSequence classes to a module
+// (pybind11_protobuf.delimited_io is a module which only contains those):
+//
+//   reader = delimited_io.DelimitedMessageReader(mmap_file, my_pb2.Event)
+//   for events in iter(lambda: reader.read(4096), []):
+//     ...
+//
+//   # Indexes the file once; events[i] parses only the i-th message.
+//   events = delimited_io.LazyMessageSequence(mmap_file, my_pb2.Event)
+//
+// From C++, for example in a function bound with pybind11:
+//
+//   m.def("count_errors", [](py::handle source) {
+//     int errors = 0;
+//     pybind11_protobuf::ReadDelimitedMessages<Event>(
+//         source, [&](const Event& event) { errors += event.has_error(); });
+//     return errors;
+//   });
+
+namespace pybind11_protobuf {
+
+// Reads a stream of length-delimited messages from a python object, which may
+// be:
+// * an object supporting the buffer protocol, such as bytes, memoryview or
+//   mmap.mmap; the buffer is held, and read in place, until destruction.
+// * an int file descriptor, read from the current position.
+// * a binary file object with a read() method.
+//
+// Must be constructed and destroyed with the GIL held.
+class DelimitedInputSource {
+ public:
+  explicit DelimitedInputSource(pybind11::handle source);
+  ~DelimitedInputSource();
+
+  DelimitedInputSource(const DelimitedInputSource &) = delete;
+  DelimitedInputSource &operator=(const DelimitedInputSource &) = delete;
+
+  // Clears `message` and parses the next message into it. Returns false at a
+  // clean end of the stream. Throws ValueError for a truncated or malformed
+  // message, or the python exception raised by a file object.
+  bool ReadMessage(::google::protobuf::MessageLite *message);
+
+  // Like ReadMessage(), but returns the serialized message.
+  bool ReadRecord(std::string *record);
+
+  // Whether reads call into python, which is the case for file objects. When
+  // false, the reads may be done with the GIL released.
+  bool requires_gil() const { return requires_gil_; }
+
+ private:
+  struct Buffer;
+  class PyFileInputStream;
+
+  // Returns false at a clean end of the stream, else throws.
+  bool HandleReadFailure(bool clean_eof, const std::string &type_name);
+
+  pybind11::object source_;
+  std::unique_ptr<Buffer> buffer_;
+  std::unique_ptr<PyFileInputStream> file_;
+  std::unique_ptr<::google::protobuf::io::ZeroCopyInputStream> stream_;
+  bool requires_gil_ = false;
+};
+
+// Writes a stream of length-delimited messages to a python object, which may
+// be an int file descriptor or a binary file object with a write() method.
+// Output is buffered until Flush() or destruction.
+//
+// Must be constructed and destroyed with the GIL held.
+class DelimitedOutputSink {
+ public:
+  explicit DelimitedOutputSink(pybind11::handle sink);
+  ~DelimitedOutputSink();
+
+  DelimitedOutputSink(const DelimitedOutputSink &) = delete;
+  DelimitedOutputSink &operator=(const DelimitedOutputSink &) = delete;
+
+  // Writes the length-delimited message. Throws ValueError when `message` is
+  // missing required fields, or the error raised by the file object.
+  void WriteMessage(const ::google::protobuf::MessageLite &message);
+
+  // Writes a length-delimited, already serialized message.
+  void WriteRecord(absl::string_view record);
+
+  // Writes buffered output to the underlying file descriptor or file object.
+  void Flush();
+
+  bool requires_gil() const { return requires_gil_; }
+
+ private:
+  class PyFileOutputStream;
+
+  ::google::protobuf::io::ZeroCopyOutputStream *stream();
+  void CheckWriteError(bool ok);
+
+  pybind11::object sink_;
+  std::unique_ptr<::google::protobuf::io::FileOutputStream> fd_stream_;
+  std::unique_ptr<PyFileOutputStream> file_;
+  std::unique_ptr<::google::protobuf::io::CopyingOutputStreamAdaptor>
+      file_stream_;
+  bool requires_gil_ = false;
+};
+
+// Calls `callback` with each message of type ProtoType read from `source`
+// (see DelimitedInputSource), without creating python objects. Returns the
+// number of messages read. The GIL must be held, and stays held.
+template <typename ProtoType>
+size_t ReadDelimitedMessages(
+    pybind11::handle source,
+    const std::function<void(const ProtoType &)> &callback) {
+  DelimitedInputSource input(source);
+  ProtoType message;
+  size_t count = 0;
+  while (input.ReadMessage(&message)) {
+    callback(message);
+    ++count;
+  }
+  return count;
+}
+
+// Adds the DelimitedMessageReader, DelimitedMessageWriter and
+// LazyMessageSequence classes to `m`.
+// The classes are module_local, so this may be called by several extension
+// modules. Messages of types compiled into the calling extension are parsed
+// and serialized in C++; other types use message_type.FromString().
+void RegisterDelimitedMessageIO(pybind11::module_ m);
+
+}  // namespace pybind11_protobuf
+
+#endif  // PYBIND11_PROTOBUF_DELIMITED_MESSAGE_IO_H_
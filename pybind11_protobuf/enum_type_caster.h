@@ -11,6 +11,7 @@
 #include <pybind11/pybind11.h>
 #include <pybind11/pytypes.h>
 
+#include <limits>
 #include <string>
 #include <type_traits>
 
@@ -61,6 +62,19 @@ struct enum_type_caster {
 
   // load converts from Python -> C++
   bool load(pybind11::handle src, bool convert) {
+    // Exact ints, which include the values of python proto enums, are
+    // converted directly; this is the per-element path of std::vector<Enum>
+    // and other containers. Everything else goes through the int caster.
+    if (PyLong_CheckExact(src.ptr())) {
+      int overflow = 0;
+      long long v = PyLong_AsLongLongAndOverflow(src.ptr(), &overflow);
+      if (!overflow && v >= std::numeric_limits<T>::min() &&
+          v <= std::numeric_limits<T>::max()) {
+        value = static_cast<EnumType>(v);
+        return true;
+      }
+      PyErr_Clear();
+    }
     base_caster base;
     if (base.load(src, convert)) {
       T v = static_cast<T>(base);
@@ -11,14 +11,18 @@
 // IWYU
 #include <Python.h>
 
+#include <cstddef>
 #include <functional>
 #include <memory>
 #include <optional>
 #include <string>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
+#include "google/protobuf/descriptor.h"
 #include "google/protobuf/message.h"
+#include "google/protobuf/repeated_field.h"
 #include "absl/strings/string_view.h"
 #include "pybind11_protobuf/check_unknown_fields.h"
 #include "pybind11_protobuf/enum_type_caster.h"
@@ -61,6 +65,56 @@ namespace pybind11_protobuf {
 // is required to be called from a PYBIND11_MODULE definition before use.
 inline void ImportNativeProtoCasters() { InitializePybindProtoCastUtil(); }
 
+// Like ImportNativeProtoCasters(), and also imports the python modules of the
+// `preload` message types and caches their classes in one batch, so that the
+// first calls returning those types skip the class lookup:
+//
+//   pybind11_protobuf::ImportNativeProtoCasters(
+//       {MyRequest::descriptor(), MyResponse::descriptor()});
+//
+// Throws a type_error when a class cannot be found.
+inline void ImportNativeProtoCasters(
+    const std::vector<const ::google::protobuf::Descriptor *> &preload) {
+  InitializePybindProtoCastUtil();
+  PreloadPyMessageClasses(preload);
+}
+
+// Alternative to ImportNativeProtoCasters() which imports nothing: the casters
+// then initialize themselves, importing the protobuf python modules, on the
+// first conversion, so extension modules which seldom convert protos add
+// nothing to startup time. A missing dependency on protobuf_python is then
+// reported by that first conversion rather than at import. Threads racing
+// through a first conversion may each initialize the state, in which case
+// one copy is kept and the others are deleted.
+inline void ImportNativeProtoCastersLazily() {}
+
+// Pre-warms the python message class cache for ProtoType. May be called from a
+// PYBIND11_MODULE definition, after ImportNativeProtoCasters(), to move the
+// class lookup out of the first call returning ProtoType.
+template <typename ProtoType>
+void PreloadProtoMessageClass() {
+  PreloadPyMessageClass(ProtoType::descriptor());
+}
+
+// Releases the GIL while parsing or serializing protos of at least `bytes`
+// bytes when converting them between C++ and python, so that other python
+// threads can run. Returned messages are only serialized without the GIL for
+// return_value_policy move and take_ownership, such as returns by value or
+// std::unique_ptr. Zero, the default, disables this. Releasing and
+// reacquiring the GIL has a cost, so the threshold should be large; a few
+// hundred kilobytes is a reasonable starting point.
+inline void ReleaseGilForLargeProtos(size_t bytes) {
+  SetGilReleaseThreshold(bytes);
+}
+
+// Releases the python objects cached for messages from a dynamic
+// DescriptorPool. Call this before destroying the pool; python messages from
+// the pool must not outlive it either way.
+inline void ReleaseDescriptorPoolCache(
+    const ::google::protobuf::DescriptorPool* pool) {
+  ReleasePyDescriptorPool(pool);
+}
+
 inline void AllowUnknownFieldsFor(
     absl::string_view top_message_descriptor_full_name,
     absl::string_view unknown_field_parent_message_fqn) {
@@ -156,6 +210,13 @@ struct move_only_holder_caster<
 // methods that return a shared_ptr<const T>, which the caller never intends
 // to mutate and where copy semantics will work just as well.
 //
+// When read-only views are enabled for the proto (see
+// pybind11_protobuf_enable_read_only_views), a returned
+// std::shared_ptr<const Proto> instead becomes a view sharing ownership of the
+// message, and loading such a view back into a std::shared_ptr<const Proto>
+// returns the original pointer; views behave as copy-on-write via
+// materialize().
+//
 template <typename ProtoType, typename HolderType>
 struct copyable_holder_caster<
     ProtoType, HolderType,
@@ -166,6 +227,9 @@ struct copyable_holder_caster<
   using Base = type_caster<intrinsic_t<ProtoType>>;
   static constexpr bool const_element =
       std::is_const<typename HolderType::element_type>::value;
+  static constexpr bool shared_const_ptr =
+      const_element &&
+      std::is_same<HolderType, std::shared_ptr<ProtoType>>::value;
 
  public:
   static constexpr auto name = Base::name;
@@ -173,14 +237,30 @@ struct copyable_holder_caster<
   // C++->Python.
   static handle cast(const HolderType &src, return_value_policy, handle p) {
     // The default path calls into cast_holder so that the holder/deleter
-    // gets added to the proto. Here we just make a copy
+    // gets added to the proto. Here we just make a copy, unless the
+    // message can be shared with a read-only view.
     const auto *ptr = holder_helper<HolderType>::get(src);
     if (!ptr) return none().release();
+    if constexpr (shared_const_ptr &&
+                  pybind11_protobuf::read_only_views_enabled<
+                      intrinsic_t<ProtoType>>()) {
+      return pybind11_protobuf::GenericProtoViewCast(ptr, handle(), src);
+    }
     return Base::cast(*ptr, return_value_policy::copy, p);
   }
 
   // Convert Python->C++.
   bool load(handle src, bool convert) {
+    if constexpr (shared_const_ptr) {
+      // Hand back the message shared by a read-only view.
+      if (auto owner = pybind11_protobuf::PyProtoViewGetOwner(src)) {
+        if (const auto *ptr = dynamic_cast<const intrinsic_t<ProtoType> *>(
+                pybind11_protobuf::PyProtoViewGetCppMessagePointer(src))) {
+          holder = HolderType(owner, ptr);
+          return true;
+        }
+      }
+    }
     Base base;
     if (!base.load(src, convert)) {
       return false;
@@ -201,6 +281,63 @@ struct copyable_holder_caster<
   HolderType holder;
 };
 
+// type_caster<> for ::google::protobuf::RepeatedPtrField<ProtoType>, converting to and from
+// a python list. C++ -> python conversion is batched, see cast_proto_list().
+template <typename ProtoType>
+struct type_caster<
+    ::google::protobuf::RepeatedPtrField<ProtoType>,
+    std::enable_if_t<(std::is_base_of<::google::protobuf::Message, ProtoType>::value &&
+                      pybind11_protobuf_enable_type_caster(
+                          static_cast<ProtoType *>(nullptr)))>> {
+  using RepeatedType = ::google::protobuf::RepeatedPtrField<ProtoType>;
+
+ public:
+  static constexpr auto name = const_name("List[") +
+                               make_caster<ProtoType>::name + const_name("]");
+
+  // C++->Python.
+  static handle cast(RepeatedType &&src, return_value_policy, handle) {
+    return pybind11_protobuf::cast_proto_list<ProtoType>(src, /*move=*/true);
+  }
+  static handle cast(const RepeatedType &src, return_value_policy, handle) {
+    return pybind11_protobuf::cast_proto_list<ProtoType>(src, /*move=*/false);
+  }
+  static handle cast(const RepeatedType *src, return_value_policy policy,
+                     handle p) {
+    if (!src) return none().release();
+    return cast(*src, policy, p);
+  }
+
+  // Convert Python->C++.
+  bool load(handle src, bool) {
+    using load_impl = pybind11_protobuf::proto_caster_load_impl<ProtoType>;
+    if (!isinstance<sequence>(src) || isinstance<bytes>(src) ||
+        isinstance<str>(src)) {
+      return false;
+    }
+    auto s = reinterpret_borrow<sequence>(src);
+    value.Clear();
+    value.Reserve(static_cast<int>(s.size()));
+    for (auto it : s) {
+      if (!load_impl::load_into(it, value.Add())) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // PYBIND11_TYPE_CASTER
+  explicit operator RepeatedType *() { return &value; }
+  explicit operator RepeatedType &() { return value; }
+  explicit operator RepeatedType &&() && { return std::move(value); }
+
+  template <typename T_>
+  using cast_op_type = pybind11::detail::movable_cast_op_type<T_>;
+
+ protected:
+  RepeatedType value;
+};
+
 // NOTE: We also need to add support and/or test classes:
 //
 //  ::google::protobuf::Descriptor
@@ -5,24 +5,43 @@
 #include <pybind11/pybind11.h>
 #include <pybind11/pytypes.h>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>  // NOLINT(build/c++11)
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
 #include <initializer_list>
 #include <iostream>
 #include <memory>
 #include <string>
+#include <system_error>
+#include <thread>  // NOLINT(build/c++11)
+#include <tuple>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 #include "google/protobuf/descriptor.pb.h"
 #include "google/protobuf/descriptor.h"
+#include "google/protobuf/descriptor_database.h"
 #include "google/protobuf/dynamic_message.h"
 #include "google/protobuf/message.h"
+#include "google/protobuf/reflection.h"
 #include "python/google/protobuf/proto_api.h"
 #include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/str_replace.h"
 #include "absl/strings/str_split.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/types/optional.h"
 #include "pybind11_protobuf/check_unknown_fields.h"
+#include "pybind11_protobuf/proto_view.h"
 
 namespace py = pybind11;
 
@@ -31,10 +50,13 @@ using ::google::protobuf::DescriptorDatabase;
 using ::google::protobuf::DescriptorPool;
 using ::google::protobuf::DescriptorProto;
 using ::google::protobuf::DynamicMessageFactory;
+using ::google::protobuf::FieldDescriptor;
 using ::google::protobuf::FileDescriptor;
 using ::google::protobuf::FileDescriptorProto;
 using ::google::protobuf::Message;
 using ::google::protobuf::MessageFactory;
+using ::google::protobuf::Reflection;
+using ::google::protobuf::SimpleDescriptorDatabase;
 using ::google::protobuf::python::PyProto_API;
 using ::google::protobuf::python::PyProtoAPICapsuleName;
 
@@ -49,6 +71,13 @@ std::string PythonPackageForDescriptor(const FileDescriptor* file) {
   return absl::StrReplaceAll(name, replacements);
 }
 
+[[noreturn]] void ThrowMissingMessageClass(const Descriptor* descriptor) {
+  throw py::type_error("Cannot construct a protocol buffer message type " +
+                       descriptor->full_name() +
+                       " in python. Is there a missing dependency on module " +
+                       PythonPackageForDescriptor(descriptor->file()) + "?");
+}
+
 // Resolves the class name of a descriptor via d->containing_type()
 py::object ResolveDescriptor(py::object p, const Descriptor* d) {
   return d->containing_type() ? ResolveDescriptor(p, d->containing_type())
@@ -65,6 +94,18 @@ bool IsImportError(py::error_already_set& e) {
 #endif
 }
 
+// Returns whether a module is in sys.modules, without importing it.
+bool IsModuleImported(const std::string& module_name) {
+  py::str name(module_name);
+  PyObject* module = PyImport_GetModule(name.ptr());
+  if (module == nullptr) {
+    PyErr_Clear();
+    return false;
+  }
+  Py_DECREF(module);
+  return true;
+}
+
 // Resolves a sequence of python attrs starting from obj.
 // If any does not exist, returns nullopt.
 absl::optional<py::object> ResolveAttrs(
@@ -122,6 +163,247 @@ absl::optional<py::object> ResolveAttrMRO(py::handle obj, const char* name) {
   return absl::nullopt;
 }
 
+// Wire size at or above which parsing and serializing release the GIL.
+// Zero disables releasing the GIL. See SetGilReleaseThreshold().
+std::atomic<size_t> gil_release_threshold{0};
+
+// See SetParallelLoad().
+std::atomic<size_t> parallel_load_batch_size{0};
+std::atomic<int> parallel_load_threads{0};
+
+// Conversion statistics; see EnableCasterStats(). Counters are only updated
+// while enabled, so disabled stats cost a relaxed load per conversion.
+std::atomic<bool> caster_stats_enabled{false};
+
+enum CastPath {
+  kBorrow,
+  kSwap,
+  kCopyFrom,
+  kSerialize,
+  kFieldCopy,
+  kUnknownFieldCheck,
+  kNumCastPaths,
+};
+
+constexpr const char* kCastPathNames[kNumCastPaths] = {
+    "borrow",     "swap",      "copy_from", "serialize",
+    "field_copy", "unknown_field_check"};
+
+// latency_us[0] counts conversions which took under a microsecond, and
+// latency_us[i] those which took [2**(i-1), 2**i) microseconds; the last
+// bucket also holds all slower ones.
+constexpr int kLatencyBuckets = 24;
+
+struct CastStats {
+  uint64_t paths[kNumCastPaths] = {};
+  uint64_t bytes = 0;
+  uint64_t latency_us[kLatencyBuckets] = {};
+};
+
+// The statistics of this extension module, by message full_name. Updates may
+// come from threads parsing without the GIL, hence the mutex.
+class CastStatsTable {
+ public:
+  static CastStatsTable* instance() {
+    static auto* table = new CastStatsTable();
+    return table;
+  }
+
+  void RecordPath(absl::string_view full_name, CastPath path, size_t bytes) {
+    absl::MutexLock lock(&mutex_);
+    CastStats& stats = Entry(full_name);
+    ++stats.paths[path];
+    stats.bytes += bytes;
+  }
+
+  // Adds the paths and bytes of `conversion`, and its latency, in a single
+  // update.
+  void RecordConversion(absl::string_view full_name,
+                        const CastStats& conversion, int64_t micros) {
+    int bucket = 0;
+    while (bucket + 1 < kLatencyBuckets && micros >= (int64_t{1} << bucket)) {
+      ++bucket;
+    }
+    absl::MutexLock lock(&mutex_);
+    CastStats& stats = Entry(full_name);
+    for (int i = 0; i < kNumCastPaths; ++i) {
+      stats.paths[i] += conversion.paths[i];
+    }
+    stats.bytes += conversion.bytes;
+    ++stats.latency_us[bucket];
+  }
+
+  void Reset() {
+    absl::MutexLock lock(&mutex_);
+    stats_.clear();
+  }
+
+  py::dict ToPython() {
+    std::vector<std::pair<std::string, CastStats>> snapshot;
+    {
+      absl::MutexLock lock(&mutex_);
+      snapshot.assign(stats_.begin(), stats_.end());
+    }
+    py::dict result;
+    for (const auto& [full_name, stats] : snapshot) {
+      py::dict entry;
+      for (int i = 0; i < kNumCastPaths; ++i) {
+        entry[kCastPathNames[i]] = stats.paths[i];
+      }
+      entry["bytes"] = stats.bytes;
+      py::list latency(kLatencyBuckets);
+      for (int i = 0; i < kLatencyBuckets; ++i) {
+        latency[i] = py::int_(stats.latency_us[i]);
+      }
+      entry["latency_us"] = std::move(latency);
+      result[py::str(full_name)] = std::move(entry);
+    }
+    return result;
+  }
+
+ private:
+  CastStats& Entry(absl::string_view full_name)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    auto it = stats_.find(full_name);
+    if (it == stats_.end()) {
+      it = stats_.emplace(std::string(full_name), CastStats()).first;
+    }
+    return it->second;
+  }
+
+  absl::Mutex mutex_;
+  absl::flat_hash_map<std::string, CastStats> stats_ ABSL_GUARDED_BY(mutex_);
+};
+
+bool CastStatsEnabled() {
+  return caster_stats_enabled.load(std::memory_order_relaxed);
+}
+
+// Records the latency of a conversion, when stats are enabled. The paths
+// taken by the conversion are collected by the innermost timer of the thread,
+// so that the table is locked once per conversion.
+class ScopedCastTimer {
+ public:
+  explicit ScopedCastTimer(const Descriptor* descriptor)
+      : descriptor_(CastStatsEnabled() ? descriptor : nullptr) {
+    if (!descriptor_) return;
+    outer_ = std::exchange(innermost_, this);
+    start_ = std::chrono::steady_clock::now();
+  }
+  ~ScopedCastTimer() {
+    if (!descriptor_) return;
+    innermost_ = outer_;
+    auto elapsed = std::chrono::steady_clock::now() - start_;
+    CastStatsTable::instance()->RecordConversion(
+        descriptor_->full_name(), conversion_,
+        std::chrono::duration_cast<std::chrono::microseconds>(elapsed)
+            .count());
+  }
+
+  ScopedCastTimer(const ScopedCastTimer&) = delete;
+  ScopedCastTimer& operator=(const ScopedCastTimer&) = delete;
+
+  // Adds a path to the innermost conversion of this thread, when it converts
+  // `descriptor`. Returns false otherwise.
+  static bool AddPath(const Descriptor* descriptor, CastPath path,
+                      size_t bytes) {
+    ScopedCastTimer* timer = innermost_;
+    if (timer == nullptr || timer->descriptor_ != descriptor) return false;
+    ++timer->conversion_.paths[path];
+    timer->conversion_.bytes += bytes;
+    return true;
+  }
+
+ private:
+  static inline thread_local ScopedCastTimer* innermost_ = nullptr;
+
+  const Descriptor* descriptor_;
+  ScopedCastTimer* outer_ = nullptr;
+  std::chrono::steady_clock::time_point start_;
+  CastStats conversion_;
+};
+
+void RecordCastPath(const Descriptor* descriptor, CastPath path,
+                    size_t bytes = 0) {
+  if (!CastStatsEnabled()) return;
+  if (ScopedCastTimer::AddPath(descriptor, path, bytes)) return;
+  CastStatsTable::instance()->RecordPath(descriptor->full_name(), path, bytes);
+}
+
+// The interpreter-wide registry of the stats of all extension modules which
+// share pybind11 internals: a dict holding "enabled", and "sources", which
+// maps an id of each extension module to its (stats, reset, enable)
+// callables.
+py::dict CastStatsRegistry() {
+  auto& registry =
+      py::get_or_create_shared_data<py::dict>("pybind11_protobuf_cast_stats");
+  if (!registry.contains("sources")) {
+    registry["enabled"] = false;
+    registry["sources"] = py::dict();
+  }
+  return registry;
+}
+
+// Adds the stats of this extension module to the registry, when its casters
+// are initialized.
+void RegisterCastStatsSource() {
+  py::dict registry = CastStatsRegistry();
+  auto sources = registry["sources"].cast<py::dict>();
+  // The table is unique to the copy of this file linked into each extension.
+  py::int_ id(reinterpret_cast<uintptr_t>(CastStatsTable::instance()));
+  if (sources.contains(id)) return;
+  sources[id] = py::make_tuple(py::cpp_function(&GetCasterStats),
+                               py::cpp_function(&ResetCasterStats),
+                               py::cpp_function(&EnableCasterStats));
+  if (registry["enabled"].cast<bool>()) EnableCasterStats(true);
+}
+
+bool ShouldReleaseGil(size_t size) {
+  size_t threshold = gil_release_threshold.load(std::memory_order_relaxed);
+  return threshold != 0 && size >= threshold;
+}
+
+// Parses into a message which is not reachable from python code, releasing
+// the GIL for large inputs. The caller keeps the buffer alive.
+bool ParsePartialMaybeReleasingGil(Message* message, const char* data,
+                                   size_t size) {
+  if (ShouldReleaseGil(size)) {
+    py::gil_scoped_release release;
+    return message->ParsePartialFromArray(data, static_cast<int>(size));
+  }
+  return message->ParsePartialFromArray(data, static_cast<int>(size));
+}
+
+// Serializes a message, releasing the GIL for large outputs when `owned`.
+// Only messages owned by the caster, such as those being moved or whose
+// ownership is taken, may be serialized without the GIL: any other message,
+// such as a const reference to a member or a global, may be mutated by other
+// python threads through its bindings meanwhile.
+std::string SerializePartialMaybeReleasingGil(const Message& message,
+                                              bool owned) {
+  if (owned && gil_release_threshold.load(std::memory_order_relaxed) != 0 &&
+      ShouldReleaseGil(message.ByteSizeLong())) {
+    py::gil_scoped_release release;
+    return message.SerializePartialAsString();
+  }
+  return message.SerializePartialAsString();
+}
+
+// Copies src into dst. Messages sharing a descriptor are copied using
+// (possibly reflection based) CopyFrom, otherwise the wire format is used,
+// serialized into a C++-owned buffer.
+bool CProtoCopyToCProto(const Message& src, Message* dst) {
+  if (src.GetDescriptor() == dst->GetDescriptor()) {
+    RecordCastPath(dst->GetDescriptor(), kCopyFrom);
+    dst->CopyFrom(src);
+    return true;
+  }
+  std::string wire;
+  if (!src.SerializePartialToString(&wire)) return false;
+  RecordCastPath(dst->GetDescriptor(), kSerialize, wire.size());
+  return dst->ParsePartialFromString(wire);
+}
+
 absl::optional<std::string> CastToOptionalString(py::handle src) {
   // Avoid pybind11::cast because it throws an exeption.
   pybind11::detail::make_caster<std::string> c;
@@ -147,46 +429,242 @@ uint64_t VersionStringToNumericVersion(absl::string_view version_str) {
 }
 #endif
 
+// Returns true when the PyProto_API implementation resolves compiled-in
+// descriptors to the very same Descriptor instances as this CU. That only
+// happens when the python protobuf extension and this extension share a single
+// protobuf runtime (and thus a single generated_pool()), which is the property
+// that makes borrowing a C++ Message* from a python object safe.
+//
+// The protobuf versions are expected to have been checked before calling this.
+bool PyProtoApiSharesGeneratedPool(const PyProto_API* py_proto_api) {
+  const DescriptorPool* py_pool = py_proto_api->GetDefaultDescriptorPool();
+  if (py_pool == nullptr) return false;
+  if (py_pool == DescriptorPool::generated_pool()) return true;
+
+  // The python default pool is usually a separate pool which uses the
+  // generated_pool() as an underlay, so probe it with a descriptor which is
+  // always compiled into the protobuf runtime.
+  const Descriptor* expected = FileDescriptorProto::descriptor();
+  return py_pool->FindMessageTypeByName(expected->full_name()) == expected;
+}
+
+// A map for caches which are read on every cast and rarely change.
+//
+// Lookups are a lock-free probe of an immutable snapshot; updates copy the
+// snapshot under a mutex and publish the copy. With the GIL, which both
+// readers and writers hold, the replaced snapshot is deleted right away. In
+// free-threaded builds concurrent readers may still be using it, so it is
+// leaked; there is one per insert, which is why entries cannot be erased and
+// this is only used for caches with a bounded set of keys.
+//
+// Never call into python while holding the mutex: python code may release
+// the GIL (or, free-threaded, re-enter the cache) and deadlock. Compute the
+// value first, then Insert() it.
+template <typename Key, typename Value>
+class ReadMostlyMap {
+ public:
+  using Map = absl::flat_hash_map<Key, Value>;
+
+  ReadMostlyMap() : snapshot_(new Map()) {}
+  ReadMostlyMap(const ReadMostlyMap&) = delete;
+  ReadMostlyMap& operator=(const ReadMostlyMap&) = delete;
+  ~ReadMostlyMap() { delete snapshot_.load(std::memory_order_acquire); }
+
+  // Returns the value for `key`, or nullptr. The pointer is valid until the
+  // next Insert(); copy the value before calling into python.
+  const Value* Find(const Key& key) const {
+    const Map* current = snapshot_.load(std::memory_order_acquire);
+    auto it = current->find(key);
+    return it == current->end() ? nullptr : &it->second;
+  }
+
+  // Inserts `value` unless `key` is already present, in which case `value` is
+  // dropped and the value in the map is returned instead. A dropped raw
+  // pointer is not deleted: callers inserting owning pointers compare the
+  // result and delete their own value when they lost the race.
+  Value Insert(const Key& key, Value value) {
+    const Map* replaced;
+    {
+      absl::MutexLock lock(&mutex_);
+      replaced = snapshot_.load(std::memory_order_acquire);
+      auto it = replaced->find(key);
+      if (it != replaced->end()) return it->second;
+      auto* updated = new Map(*replaced);
+      updated->emplace(key, value);
+      snapshot_.store(updated, std::memory_order_release);
+    }
+    Retire(replaced);
+    return value;
+  }
+
+ private:
+  // Deletes a replaced snapshot, outside the mutex since that may drop the
+  // last reference to python objects.
+  static void Retire(const Map* replaced) {
+#if defined(Py_GIL_DISABLED)
+    (void)replaced;
+#else
+    delete replaced;
+#endif
+  }
+
+  std::atomic<const Map*> snapshot_;
+  absl::Mutex mutex_;
+};
+
+// Returns the id of the current interpreter. Unlike the PyInterpreterState
+// address, ids are never reused by later subinterpreters.
+int64_t CurrentInterpreterId() {
+#if PY_VERSION_HEX >= 0x03090000
+  return PyInterpreterState_GetID(PyInterpreterState_Get());
+#else
+  return PyInterpreterState_GetID(PyThreadState_Get()->interp);
+#endif
+}
+
+// Holds one leaked instance of T per python interpreter, since the python
+// objects held by T belong to the interpreter which created them.
+template <typename T>
+class PerInterpreter {
+ public:
+  // Returns the instance for the current interpreter, calling `create` on
+  // first use. `create` may call into python, which may let another thread
+  // create an instance too; the first one inserted is kept and the others
+  // are deleted before they are returned to anyone.
+  template <typename Create>
+  T* Get(Create create) {
+    const int64_t id = CurrentInterpreterId();
+    if (T* const* found = instances_.Find(id)) return *found;
+    T* created = create();
+    T* instance = instances_.Insert(id, created);
+    if (instance != created) delete created;
+    return instance;
+  }
+
+ private:
+  ReadMostlyMap<int64_t, T*> instances_;
+};
+
 class GlobalState {
  public:
-  // Global state singleton intentionally leaks at program termination.
+  // Global state singletons intentionally leak at program termination.
   // If destructed along with other static variables, it causes segfaults
   // due to order of destruction conflict with python threads. See
   // https://github.com/pybind/pybind11/issues/1598
+  //
+  // There is one instance per interpreter, so subinterpreters never see the
+  // modules and classes of another interpreter.
   static GlobalState* instance() {
-    static auto instance = new GlobalState();
-    return instance;
+    static auto instances = new PerInterpreter<GlobalState>();
+    return instances->Get([] { return new GlobalState(); });
   }
 
   py::handle global_pool() { return global_pool_; }
   const PyProto_API* py_proto_api() { return py_proto_api_; }
   bool using_fast_cpp() const { return using_fast_cpp_; }
+  bool using_pure_python() const { return using_pure_python_; }
+
+  // Whether C++ message pointers obtained through the PyProto_API may be used
+  // directly by this CU. See PyProtoApiSharesGeneratedPool().
+  bool abi_compatible() const { return abi_compatible_; }
 
   // Allocate a python proto message instance using the native python
   // allocations.
   py::object PyMessageInstance(const Descriptor* descriptor);
 
+  // Returns the python message class for a descriptor. Classes for compiled-in
+  // descriptors are cached, so repeated lookups are a single hash probe.
+  py::object PyMessageClass(const Descriptor* descriptor);
+
   // Allocates a fast cpp proto python object, also returning
   // the embedded c++ proto2 message type. The returned message
   // pointer cannot be null.
   std::pair<py::object, Message*> PyFastCppProtoMessageInstance(
       const Descriptor* descriptor);
 
+  // What PyProtoIsCompatible() and PyProtoDescriptorName() need to know about
+  // a python message class.
+  struct PyMessageTypeInfo {
+    std::string full_name;
+    // The compiled-in descriptor instances of the class are compatible with,
+    // or nullptr.
+    const Descriptor* compatible_descriptor = nullptr;
+    // Erases the cache entry once the class is collected, as another type may
+    // then be allocated at the same address.
+    py::object watcher;
+  };
+
+  // Returns the cached info for the type of `py_proto`, computing it on first
+  // use. Returns nullptr when the type cannot be cached: its instances do not
+  // share the class DESCRIPTOR, or the type does not support weak references.
+  std::shared_ptr<const PyMessageTypeInfo> PyMessageTypeInfoOf(
+      py::handle py_proto);
+
+  // Drops the cached python pool and message classes for a C++ pool.
+  void ReleasePyDescriptorPool(const DescriptorPool* pool) {
+    assert(PyGILState_Check());
+    PyPoolEntry released;
+    {
+      absl::MutexLock lock(&py_pool_mutex_);
+      auto it = py_pool_cache_.find(pool);
+      if (it == py_pool_cache_.end()) return;
+      released = std::move(it->second);
+      py_pool_cache_.erase(it);
+    }
+    // `released` is destroyed without the mutex, as that may run python code.
+  }
+
   // Import (and cache) a python module.
   py::module_ ImportCached(const std::string& module_name);
 
+  // Like ImportCached(), but returns false instead of raising when the module
+  // cannot be imported. The failure is reported on the first attempt only;
+  // later attempts are a single hash probe until the module appears in
+  // sys.modules, for example when imported by python code.
+  bool TryImportCached(const std::string& module_name);
+
  private:
   GlobalState();
 
   const PyProto_API* py_proto_api_ = nullptr;
   bool using_fast_cpp_ = false;
+  bool using_pure_python_ = false;
+  bool abi_compatible_ = false;
   py::object global_pool_;
   py::object factory_;
   py::object find_message_type_by_name_;
   py::object get_prototype_;
   py::object get_message_class_;
 
-  absl::flat_hash_map<std::string, py::module_> import_cache_;
+  ReadMostlyMap<std::string, py::module_> import_cache_;
+  ReadMostlyMap<const Descriptor*, py::object> message_class_cache_;
+
+  // Negative caches: modules which failed to import, and compiled-in
+  // descriptors without a python class, mapped to their module name. Both
+  // are bypassed once the module shows up in sys.modules.
+  ReadMostlyMap<std::string, bool> failed_imports_;
+  ReadMostlyMap<const Descriptor*, std::string> missing_classes_;
+
+  // Python types come and go, so entries are erased and this is guarded by a
+  // mutex rather than a ReadMostlyMap.
+  absl::Mutex py_message_types_mutex_;
+  absl::flat_hash_map<PyTypeObject*, std::shared_ptr<const PyMessageTypeInfo>>
+      py_message_types_ ABSL_GUARDED_BY(py_message_types_mutex_);
+
+  // Python pools wrapping C++ pools for the fast_cpp_proto path, along with
+  // the message classes created from them. Entries may be released, so this
+  // is guarded by a mutex rather than a ReadMostlyMap.
+  struct PyPoolEntry {
+    py::object py_pool;
+    absl::flat_hash_map<const Descriptor*, py::object> message_classes;
+  };
+  absl::Mutex py_pool_mutex_;
+  absl::flat_hash_map<const DescriptorPool*, PyPoolEntry> py_pool_cache_
+      ABSL_GUARDED_BY(py_pool_mutex_);
+
+  // Resolves the python message class for a descriptor, without caching.
+  // Returns a null object when there is none; `report` prints why.
+  py::object ResolvePyMessageClass(const Descriptor* descriptor, bool report);
 };
 
 GlobalState::GlobalState() {
@@ -227,10 +705,12 @@ GlobalState::GlobalState() {
   }
 
   // determine the proto implementation.
-  auto type =
-      ImportCached("google.protobuf.internal.api_implementation")
-          .attr("Type")();
-  using_fast_cpp_ = (CastToOptionalString(type).value_or("") == "cpp");
+  auto type = CastToOptionalString(
+                  ImportCached("google.protobuf.internal.api_implementation")
+                      .attr("Type")())
+                  .value_or("");
+  using_fast_cpp_ = (type == "cpp");
+  using_pure_python_ = (type == "python");
 
 #if defined(PYBIND11_PROTOBUF_ENABLE_PYPROTO_API)
   // DANGER: The only way to guarantee that the PyProto_API doesn't have
@@ -279,61 +759,180 @@ GlobalState::GlobalState() {
     }
   }
 #endif
+
+#if defined(PYBIND11_PROTOBUF_ASSUME_FULL_ABI_COMPATIBILITY)
+  abi_compatible_ = (py_proto_api_ != nullptr);
+#else
+  abi_compatible_ =
+      py_proto_api_ != nullptr && PyProtoApiSharesGeneratedPool(py_proto_api_);
+#endif
+
+  RegisterCastStatsSource();
 }
 
 py::module_ GlobalState::ImportCached(const std::string& module_name) {
-  auto cached = import_cache_.find(module_name);
-  if (cached != import_cache_.end()) {
-    return cached->second;
+  if (const py::module_* cached = import_cache_.Find(module_name)) {
+    return *cached;
+  }
+  return import_cache_.Insert(module_name,
+                              py::module_::import(module_name.c_str()));
+}
+
+bool GlobalState::TryImportCached(const std::string& module_name) {
+  if (import_cache_.Find(module_name) != nullptr) return true;
+  if (failed_imports_.Find(module_name) != nullptr &&
+      !IsModuleImported(module_name)) {
+    return false;
+  }
+  try {
+    ImportCached(module_name);
+    return true;
+  } catch (py::error_already_set& e) {
+    // Already reported.
+    if (failed_imports_.Find(module_name) != nullptr) return false;
+    if (IsImportError(e)) {
+      std::cerr << "Python module " << module_name << " unavailable."
+                << std::endl;
+    } else {
+      std::cerr << "Importing " << module_name << " raised an error";
+      // This prints and clears the error.
+      e.restore();
+      PyErr_Print();
+    }
+    failed_imports_.Insert(module_name, true);
+    return false;
+  }
+}
+
+std::shared_ptr<const GlobalState::PyMessageTypeInfo>
+GlobalState::PyMessageTypeInfoOf(py::handle py_proto) {
+  PyTypeObject* type = Py_TYPE(py_proto.ptr());
+  {
+    absl::MutexLock lock(&py_message_types_mutex_);
+    auto it = py_message_types_.find(type);
+    if (it != py_message_types_.end()) return it->second;
+  }
+
+  // Message classes define DESCRIPTOR on the class; mocks may not.
+  py::handle type_handle(reinterpret_cast<PyObject*>(type));
+  auto py_descriptor = ResolveAttrs(py_proto, {"DESCRIPTOR"});
+  if (!py_descriptor) return nullptr;
+  auto type_descriptor = ResolveAttrs(type_handle, {"DESCRIPTOR"});
+  if (!type_descriptor || !type_descriptor->is(*py_descriptor)) return nullptr;
+  auto py_full_name = ResolveAttrs(*py_descriptor, {"full_name"});
+  auto full_name =
+      py_full_name ? CastToOptionalString(*py_full_name) : absl::nullopt;
+  if (!full_name) return nullptr;
+
+  auto info = std::make_shared<PyMessageTypeInfo>();
+  info->full_name = *std::move(full_name);
+  // Same rules as the uncached path of PyProtoIsCompatible().
+  auto py_pool = ResolveAttrs(*py_descriptor, {"file", "pool"});
+  if (!py_pool || py_pool->is(global_pool_)) {
+    info->compatible_descriptor =
+        DescriptorPool::generated_pool()->FindMessageTypeByName(
+            info->full_name);
+  }
+  PyObject* watcher = PyWeakref_NewRef(
+      type_handle.ptr(),
+      py::cpp_function([this, type](py::handle weakref) {
+        // The entry holds the last reference to the weakref being called.
+        auto keep_alive = py::reinterpret_borrow<py::object>(weakref);
+        std::shared_ptr<const PyMessageTypeInfo> erased;
+        absl::MutexLock lock(&py_message_types_mutex_);
+        auto it = py_message_types_.find(type);
+        if (it == py_message_types_.end()) return;
+        erased = std::move(it->second);
+        py_message_types_.erase(it);
+        // `erased` is destroyed after the lock is released, and
+        // `keep_alive` after that.
+      }).ptr());
+  if (watcher == nullptr) {
+    PyErr_Clear();
+    return nullptr;
   }
-  auto module = py::module_::import(module_name.c_str());
-  import_cache_[module_name] = module;
-  return module;
+  info->watcher = py::reinterpret_steal<py::object>(watcher);
+  std::shared_ptr<const PyMessageTypeInfo> inserted = std::move(info);
+  absl::MutexLock lock(&py_message_types_mutex_);
+  // Another thread may have cached the type first; this copy is destroyed
+  // after the lock is released.
+  return py_message_types_.try_emplace(type, inserted).first->second;
 }
 
 py::object GlobalState::PyMessageInstance(const Descriptor* descriptor) {
+  return PyMessageClass(descriptor)();
+}
+
+py::object GlobalState::PyMessageClass(const Descriptor* descriptor) {
+  // Descriptors from the generated_pool() are never deallocated, so they are
+  // safe to use as cache keys; other pools may reuse addresses.
+  const bool cacheable =
+      descriptor->file()->pool() == DescriptorPool::generated_pool();
+  if (!cacheable) {
+    py::object message_class = ResolvePyMessageClass(descriptor, true);
+    if (!message_class) ThrowMissingMessageClass(descriptor);
+    return message_class;
+  }
+  if (const py::object* cached = message_class_cache_.Find(descriptor)) {
+    return *cached;
+  }
+
+  // A known miss is retried only once its module has been imported, and is
+  // not reported again.
+  bool reported = false;
+  if (const std::string* module_name = missing_classes_.Find(descriptor)) {
+    if (!IsModuleImported(*module_name)) ThrowMissingMessageClass(descriptor);
+    reported = true;
+  }
+  py::object message_class = ResolvePyMessageClass(descriptor, !reported);
+  if (!message_class) {
+    missing_classes_.Insert(descriptor,
+                            PythonPackageForDescriptor(descriptor->file()));
+    ThrowMissingMessageClass(descriptor);
+  }
+  return message_class_cache_.Insert(descriptor, std::move(message_class));
+}
+
+py::object GlobalState::ResolvePyMessageClass(const Descriptor* descriptor,
+                                              bool report) {
   auto module_name = PythonPackageForDescriptor(descriptor->file());
   if (!module_name.empty()) {
-    auto cached = import_cache_.find(module_name);
-    if (cached != import_cache_.end()) {
-      return ResolveDescriptor(cached->second, descriptor)();
+    if (const py::module_* cached = import_cache_.Find(module_name)) {
+      return ResolveDescriptor(*cached, descriptor);
     }
   }
 
-  // First attempt to construct the proto from the global pool.
+  // First attempt to find the class from the global pool.
   if (global_pool_) {
     try {
       auto d = find_message_type_by_name_(descriptor->full_name());
-      py::object p;
       if (get_message_class_) {
-        p = get_message_class_(d);
-      } else {
-        // TODO(pybind11-infra): Cleanup `MessageFactory.GetProtoType` after it
-        // is deprecated. See b/258832141.
-        p = get_prototype_(d);
+        return get_message_class_(d);
       }
-      return p();
+      // TODO(pybind11-infra): Cleanup `MessageFactory.GetProtoType` after it
+      // is deprecated. See b/258832141.
+      return get_prototype_(d);
     } catch (...) {
       // TODO(pybind11-infra): narrow down to expected exception(s).
       PyErr_Clear();
     }
   }
 
-  // If that fails, attempt to import the module.
-  if (!module_name.empty()) {
+  // If that fails, attempt to import the module. A failed import is reported,
+  // and retried, by TryImportCached() rules, so that a module which already
+  // failed in PreloadPyMessageClasses() is not imported and reported again.
+  if (!module_name.empty() && TryImportCached(module_name)) {
     try {
-      return ResolveDescriptor(ImportCached(module_name), descriptor)();
+      return ResolveDescriptor(ImportCached(module_name), descriptor);
     } catch (py::error_already_set& e) {
       // TODO(pybind11-infra): narrow down to expected exception(s).
-      e.restore();
-      PyErr_Print();
+      if (report) {
+        e.restore();
+        PyErr_Print();
+      }
     }
   }
-
-  throw py::type_error("Cannot construct a protocol buffer message type " +
-                       descriptor->full_name() +
-                       " in python. Is there a missing dependency on module " +
-                       module_name + "?");
+  return py::object();
 }
 
 std::pair<py::object, Message*> GlobalState::PyFastCppProtoMessageInstance(
@@ -341,34 +940,62 @@ std::pair<py::object, Message*> GlobalState::PyFastCppProtoMessageInstance(
   assert(descriptor != nullptr);
   assert(py_proto_api_ != nullptr);
 
-  // Create a PyDescriptorPool, temporarily, it will be used by the NewMessage
-  // API call which will store it in the classes it creates.
-  //
-  // Note: Creating Python classes is a bit expensive, it might be a good idea
-  // for client code to create the pool once, and store it somewhere along with
-  // the C++ pool; then Python pools and classes are cached and reused.
-  // Otherwise, consecutives calls to this function may or may not reuse
-  // previous classes, depending on whether the returned instance has been
-  // kept alive.
+  // Get or create a PyDescriptorPool for the C++ pool. NewMessage stores the
+  // pool in the classes it creates; the first class created for a descriptor
+  // is cached alongside the pool and used to construct later instances, so
+  // classes are created once per pool rather than whenever no earlier
+  // instance happens to be alive.
   //
   // IMPORTANT CAVEAT: The C++ DescriptorPool must not be deallocated while
-  // there are any messages using it.
+  // there are any messages using it, nor while it is in the cache.
   // Furthermore, since the cache uses the DescriptorPool address, allocating
   // a new DescriptorPool with the same address is likely to use dangling
-  // pointers.
-  // It is probably better for client code to keep the C++ DescriptorPool alive
-  // until the end of the process.
+  // pointers. Client code which tears down a dynamic DescriptorPool must call
+  // ReleasePyDescriptorPool() first.
   // TODO(amauryfa): Add weakref or on-deletion callbacks to C++ DescriptorPool.
-  py::object descriptor_pool = py::reinterpret_steal<py::object>(
-      py_proto_api_->DescriptorPool_FromPool(descriptor->file()->pool()));
-  if (descriptor_pool.ptr() == nullptr) {
-    throw py::error_already_set();
+  //
+  // The mutex is only held to copy objects in and out of the cache; python is
+  // called without it.
+  const DescriptorPool* pool = descriptor->file()->pool();
+  bool pool_cached = false;
+  py::object message_class;
+  {
+    absl::MutexLock lock(&py_pool_mutex_);
+    auto pool_it = py_pool_cache_.find(pool);
+    if (pool_it != py_pool_cache_.end()) {
+      pool_cached = true;
+      auto& classes = pool_it->second.message_classes;
+      auto class_it = classes.find(descriptor);
+      if (class_it != classes.end()) message_class = class_it->second;
+    }
+  }
+  if (!pool_cached) {
+    PyPoolEntry entry{py::reinterpret_steal<py::object>(
+        py_proto_api_->DescriptorPool_FromPool(pool))};
+    if (entry.py_pool.ptr() == nullptr) {
+      throw py::error_already_set();
+    }
+    absl::MutexLock lock(&py_pool_mutex_);
+    auto inserted = py_pool_cache_.try_emplace(pool);
+    if (inserted.second) inserted.first->second = std::move(entry);
   }
 
-  py::object result = py::reinterpret_steal<py::object>(
-      py_proto_api_->NewMessage(descriptor, nullptr));
-  if (result.ptr() == nullptr) {
-    throw py::error_already_set();
+  py::object result;
+  if (message_class) {
+    result = message_class();
+  } else {
+    result = py::reinterpret_steal<py::object>(
+        py_proto_api_->NewMessage(descriptor, nullptr));
+    if (result.ptr() == nullptr) {
+      throw py::error_already_set();
+    }
+    py::object created_class = py::type::handle_of(result);
+    absl::MutexLock lock(&py_pool_mutex_);
+    auto pool_it = py_pool_cache_.find(pool);
+    if (pool_it != py_pool_cache_.end()) {
+      pool_it->second.message_classes.try_emplace(descriptor,
+                                                  std::move(created_class));
+    }
   }
   Message* message = py_proto_api_->GetMutableMessagePointer(result.ptr());
   if (message == nullptr) {
@@ -382,12 +1009,11 @@ std::pair<py::object, Message*> GlobalState::PyFastCppProtoMessageInstance(
 // This gives an efficient way to create C++ Messages from Python definitions.
 class PythonDescriptorPoolWrapper {
  public:
-  // The singleton which handles multiple wrapped pools.
-  // It is never deallocated, but data corresponding to a Python pool
-  // is cleared when the pool is destroyed.
+  // The instance, per interpreter, which handles multiple wrapped pools.
+  // It is never deallocated, and neither are the wrapped pools (see below).
   static PythonDescriptorPoolWrapper* instance() {
-    static auto instance = new PythonDescriptorPoolWrapper();
-    return instance;
+    static auto instances = new PerInterpreter<PythonDescriptorPoolWrapper>();
+    return instances->Get([] { return new PythonDescriptorPoolWrapper(); });
   }
 
   // To build messages these 3 objects often come together:
@@ -402,15 +1028,12 @@ class PythonDescriptorPoolWrapper {
 
   // Return (and maybe create) a C++ DescriptorPool that corresponds to the
   // given Python DescriptorPool.
-  // The returned pointer has the same lifetime as the Python DescriptorPool:
-  // its data will be deleted when the Python object is deleted.
+  // The returned pointer is never deleted.
   const Data* GetPoolFromPythonPool(py::handle python_pool) {
     PyObject* key = python_pool.ptr();
-    // Get or create an entry for this key.
-    auto& pool_entry = pools_map[key];
-    if (pool_entry.database) {
+    if (const Data* const* found = pools_map.Find(key)) {
       // Found in cache, return it.
-      return &pool_entry;
+      return *found;
     }
 
     // An attempt at cleanup could be made by using a py::weakref to the
@@ -439,9 +1062,13 @@ class PythonDescriptorPoolWrapper {
       factory->SetDelegateToGeneratedFactory(true);
     }
 
-    // Cache the created objects.
-    pool_entry = Data{std::move(database), std::move(pool), std::move(factory)};
-    return &pool_entry;
+    // Cache the created objects. When another thread won the race, this
+    // duplicate has not been handed out yet, so it is deleted.
+    auto* created =
+        new Data{std::move(database), std::move(pool), std::move(factory)};
+    const Data* data = pools_map.Insert(key, created);
+    if (data != created) delete created;
+    return data;
   }
 
  private:
@@ -449,6 +1076,20 @@ class PythonDescriptorPoolWrapper {
 
   // Similar to DescriptorPoolDatabase: wraps a Python DescriptorPool
   // as a DescriptorDatabase.
+  //
+  // Python FileDescriptors are converted once: each file fetched from python
+  // is added to a native SimpleDescriptorDatabase together with all of its
+  // transitive dependencies, which the C++ pool is about to request next, so
+  // those requests and lookups of symbols they define do not call python.
+  // Missing files and symbols are remembered too. The C++ pool never asks for
+  // those again anyway, as it keeps its own set of known bad names, so that
+  // adds no staleness. Missing extensions are not remembered: the C++ pool
+  // asks again on every FindExtensionByNumber() miss, and an extension added
+  // to the python pool later, for example by importing its module, must then
+  // be found.
+  //
+  // The C++ DescriptorPool serializes calls into its database, and calls it
+  // with the GIL held.
   class DescriptorPoolDatabase : public DescriptorDatabase {
    public:
     DescriptorPoolDatabase(py::object python_pool)
@@ -460,33 +1101,36 @@ class PythonDescriptorPoolWrapper {
     // Find a file by file name.
     bool FindFileByName(const std::string& filename,
                         FileDescriptorProto* output) override {
+      if (preloaded_.FindFileByName(filename, output)) return true;
+      if (missing_files_.contains(filename)) return false;
       try {
         auto file = pool_.attr("FindFileByName")(filename);
-        return CopyToFileDescriptorProto(file, output);
+        PreloadFile(file);
+        if (preloaded_.FindFileByName(filename, output)) return true;
       } catch (py::error_already_set& e) {
-        std::cerr << "FindFileByName " << filename << " raised an error";
-
-        // This prints and clears the error.
-        e.restore();
-        PyErr_Print();
+        ReportMiss(e, "FindFileByName " + filename);
       }
+      missing_files_.insert(filename);
       return false;
     }
 
     // Find the file that declares the given fully-qualified symbol name.
     bool FindFileContainingSymbol(const std::string& symbol_name,
                                   FileDescriptorProto* output) override {
+      if (preloaded_.FindFileContainingSymbol(symbol_name, output)) {
+        return true;
+      }
+      if (missing_symbols_.contains(symbol_name)) return false;
       try {
         auto file = pool_.attr("FindFileContainingSymbol")(symbol_name);
-        return CopyToFileDescriptorProto(file, output);
+        PreloadFile(file);
+        if (preloaded_.FindFileContainingSymbol(symbol_name, output)) {
+          return true;
+        }
       } catch (py::error_already_set& e) {
-        std::cerr << "FindFileContainingSymbol " << symbol_name
-                   << " raised an error";
-
-        // This prints and clears the error.
-        e.restore();
-        PyErr_Print();
+        ReportMiss(e, "FindFileContainingSymbol " + symbol_name);
       }
+      missing_symbols_.insert(symbol_name);
       return false;
     }
 
@@ -495,24 +1139,61 @@ class PythonDescriptorPoolWrapper {
     bool FindFileContainingExtension(const std::string& containing_type,
                                      int field_number,
                                      FileDescriptorProto* output) override {
+      if (preloaded_.FindFileContainingExtension(containing_type, field_number,
+                                                 output)) {
+        return true;
+      }
       try {
         auto descriptor = pool_.attr("FindMessageTypeByName")(containing_type);
         auto file =
             pool_.attr("FindExtensionByNumber")(descriptor, field_number)
                 .attr("file");
-        return CopyToFileDescriptorProto(file, output);
+        PreloadFile(file);
+        if (preloaded_.FindFileContainingExtension(containing_type,
+                                                   field_number, output)) {
+          return true;
+        }
       } catch (py::error_already_set& e) {
-        std::cerr << "FindFileContainingExtension " << containing_type << " "
-                   << field_number << " raised an error";
-
-        // This prints and clears the error.
-        e.restore();
-        PyErr_Print();
+        ReportMiss(e, absl::StrCat("FindFileContainingExtension ",
+                                   containing_type, " ", field_number));
       }
       return false;
     }
 
    private:
+    // A KeyError is how python pools report an unknown name, which the C++
+    // pool routinely probes for; other errors are printed.
+    static void ReportMiss(py::error_already_set& e,
+                           const std::string& request) {
+      if (e.matches(PyExc_KeyError)) return;
+      std::cerr << request << " raised an error";
+
+      // This prints and clears the error.
+      e.restore();
+      PyErr_Print();
+    }
+
+    // Adds a python FileDescriptor and its transitive dependencies to
+    // preloaded_, skipping files which are already there. A file which cannot
+    // be added is left for the C++ pool to report when it needs it.
+    void PreloadFile(py::handle py_file_descriptor) {
+      std::vector<py::object> pending = {
+          py::reinterpret_borrow<py::object>(py_file_descriptor)};
+      while (!pending.empty()) {
+        py::object file = std::move(pending.back());
+        pending.pop_back();
+        auto name = CastToOptionalString(file.attr("name"));
+        if (!name || !preloaded_names_.insert(*name).second) continue;
+        FileDescriptorProto proto;
+        if (CopyToFileDescriptorProto(file, &proto)) {
+          preloaded_.Add(proto);
+        }
+        for (py::handle dependency : file.attr("dependencies")) {
+          pending.push_back(py::reinterpret_borrow<py::object>(dependency));
+        }
+      }
+    }
+
     bool CopyToFileDescriptorProto(py::handle py_file_descriptor,
                                    FileDescriptorProto* output) {
       if (GlobalState::instance()->py_proto_api()) {
@@ -541,10 +1222,14 @@ class PythonDescriptorPoolWrapper {
     }
 
     py::object pool_;  // never dereferenced.
+    SimpleDescriptorDatabase preloaded_;
+    absl::flat_hash_set<std::string> preloaded_names_;
+    absl::flat_hash_set<std::string> missing_files_;
+    absl::flat_hash_set<std::string> missing_symbols_;
   };
 
   // This map caches the wrapped objects, indexed by DescriptorPool address.
-  absl::flat_hash_map<PyObject*, Data> pools_map;
+  ReadMostlyMap<PyObject*, const Data*> pools_map;
 };
 
 }  // namespace
@@ -554,34 +1239,136 @@ void InitializePybindProtoCastUtil() {
   GlobalState::instance();
 }
 
+const PyProto_API* GetPyProtoApi() {
+  assert(PyGILState_Check());
+  return GlobalState::instance()->py_proto_api();
+}
+
 void ImportProtoDescriptorModule(const Descriptor* descriptor) {
   assert(PyGILState_Check());
   if (!descriptor) return;
   auto module_name = PythonPackageForDescriptor(descriptor->file());
   if (module_name.empty()) return;
-  try {
-    GlobalState::instance()->ImportCached(module_name);
-  } catch (py::error_already_set& e) {
-    if (IsImportError(e)) {
-      std::cerr << "Python module " << module_name << " unavailable."
-                 << std::endl;
-    } else {
-      std::cerr << "ImportDescriptorModule raised an error";
-      // This prints and clears the error.
-      e.restore();
-      PyErr_Print();
+  GlobalState::instance()->TryImportCached(module_name);
+}
+
+void PreloadPyMessageClass(const Descriptor* descriptor) {
+  assert(PyGILState_Check());
+  if (!descriptor) return;
+  GlobalState::instance()->PyMessageClass(descriptor);
+}
+
+void PreloadPyMessageClasses(
+    const std::vector<const Descriptor*>& descriptors) {
+  assert(PyGILState_Check());
+  GlobalState* state = GlobalState::instance();
+  // With the modules in the import cache, classes are looked up as module
+  // attributes rather than through the python descriptor pool.
+  absl::flat_hash_set<std::string> module_names;
+  for (const Descriptor* descriptor : descriptors) {
+    if (!descriptor) continue;
+    auto module_name = PythonPackageForDescriptor(descriptor->file());
+    if (!module_name.empty() && module_names.insert(module_name).second) {
+      state->TryImportCached(module_name);
+    }
+  }
+  for (const Descriptor* descriptor : descriptors) {
+    if (descriptor) state->PyMessageClass(descriptor);
+  }
+}
+
+void SetGilReleaseThreshold(size_t bytes) {
+  gil_release_threshold.store(bytes, std::memory_order_relaxed);
+}
+
+void SetParallelLoad(size_t batch_size, int max_threads) {
+  parallel_load_batch_size.store(batch_size, std::memory_order_relaxed);
+  parallel_load_threads.store(max_threads, std::memory_order_relaxed);
+}
+
+bool UseParallelLoad(size_t size) {
+  size_t batch_size = parallel_load_batch_size.load(std::memory_order_relaxed);
+  return parallel_load_threads.load(std::memory_order_relaxed) >= 2 &&
+         batch_size != 0 && size / 2 >= batch_size;
+}
+
+void EnableCasterStats(bool enabled) {
+  caster_stats_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+void ResetCasterStats() { CastStatsTable::instance()->Reset(); }
+
+py::dict GetCasterStats() {
+  assert(PyGILState_Check());
+  return CastStatsTable::instance()->ToPython();
+}
+
+void EnableAllCasterStats(bool enabled) {
+  assert(PyGILState_Check());
+  py::dict registry = CastStatsRegistry();
+  registry["enabled"] = enabled;
+  for (auto [id, source] : registry["sources"].cast<py::dict>()) {
+    source[py::int_(2)](enabled);
+  }
+}
+
+void ResetAllCasterStats() {
+  assert(PyGILState_Check());
+  for (auto [id, source] : CastStatsRegistry()["sources"].cast<py::dict>()) {
+    source[py::int_(1)]();
+  }
+}
+
+py::dict GetAllCasterStats() {
+  assert(PyGILState_Check());
+  py::dict result;
+  for (auto [id, source] : CastStatsRegistry()["sources"].cast<py::dict>()) {
+    py::dict stats = source[py::int_(0)]();
+    for (auto [full_name, entry] : stats) {
+      if (!result.contains(full_name)) {
+        result[full_name] = entry;
+        continue;
+      }
+      // Several extension modules converted this type; sum their counters
+      // and latency buckets.
+      auto total = result[full_name].cast<py::dict>();
+      for (auto [key, value] : py::reinterpret_borrow<py::dict>(entry)) {
+        if (py::isinstance<py::list>(value)) {
+          auto buckets = total[key].cast<py::list>();
+          auto added = py::reinterpret_borrow<py::list>(value);
+          for (size_t i = 0; i < buckets.size(); ++i) {
+            buckets[i] =
+                buckets[i].cast<uint64_t>() + added[i].cast<uint64_t>();
+          }
+        } else {
+          total[key] = total[key].cast<uint64_t>() + value.cast<uint64_t>();
+        }
+      }
     }
   }
+  return result;
+}
+
+void RecordCasterBorrow(const Message& message) {
+  RecordCastPath(message.GetDescriptor(), kBorrow);
+}
+
+void RecordCasterCopy(const Message& message) {
+  RecordCastPath(message.GetDescriptor(), kCopyFrom);
+}
+
+void ReleasePyDescriptorPool(const DescriptorPool* pool) {
+  assert(PyGILState_Check());
+  if (!pool) return;
+  GlobalState::instance()->ReleasePyDescriptorPool(pool);
 }
 
 const Message* PyProtoGetCppMessagePointer(py::handle src) {
-#if !defined(PYBIND11_PROTOBUF_ASSUME_FULL_ABI_COMPATIBILITY)
-  return nullptr;
-#else
-  // Assume that C++ proto objects are compatible as long as there is a C++
-  // message pointer.
+  // C++ proto objects are compatible as long as there is a C++ message pointer
+  // and the PyProto_API is known to share the protobuf runtime with this CU,
+  // either by assumption or because the runtime check succeeded.
   assert(PyGILState_Check());
-  if (!GlobalState::instance()->py_proto_api()) return nullptr;
+  if (!GlobalState::instance()->abi_compatible()) return nullptr;
   auto* ptr =
       GlobalState::instance()->py_proto_api()->GetMessagePointer(src.ptr());
   if (ptr == nullptr) {
@@ -590,11 +1377,13 @@ const Message* PyProtoGetCppMessagePointer(py::handle src) {
     PyErr_Clear();
   }
   return ptr;
-#endif
 }
 
 absl::optional<std::string> PyProtoDescriptorName(py::handle py_proto) {
   assert(PyGILState_Check());
+  if (auto info = GlobalState::instance()->PyMessageTypeInfoOf(py_proto)) {
+    return info->full_name;
+  }
   auto py_full_name = ResolveAttrs(py_proto, {"DESCRIPTOR", "full_name"});
   if (py_full_name) {
     return CastToOptionalString(*py_full_name);
@@ -612,6 +1401,12 @@ bool PyProtoIsCompatible(py::handle py_proto, const Descriptor* descriptor) {
     return false;
   }
 
+  // Message classes are checked once; later checks are a hash probe and a
+  // pointer compare.
+  if (auto info = GlobalState::instance()->PyMessageTypeInfoOf(py_proto)) {
+    return info->compatible_descriptor == descriptor;
+  }
+
   auto py_descriptor = ResolveAttrs(py_proto, {"DESCRIPTOR"});
   if (!py_descriptor) {
     // Not a valid protobuf -- missing DESCRIPTOR.
@@ -647,8 +1442,322 @@ bool PyProtoIsCompatible(py::handle py_proto, const Descriptor* descriptor) {
   return true;
 }
 
+namespace {
+
+// With the pure python backend, SerializePartialToString() encodes every
+// field and repeated element in python. From this many set fields plus
+// repeated numeric elements, PyProtoCopyToCProto() instead reads the fields
+// with ListFields(), which serialization calls anyway, and sets them by
+// reflection, converting the elements in C++. Smaller messages keep the wire
+// format, which needs fewer calls into python.
+constexpr size_t kMinFieldCopyCost = 32;
+
+// A field set in a python message, as returned by ListFields().
+struct PyField {
+  const FieldDescriptor* field;
+  py::object value;
+};
+
+bool IsRepeatedNumeric(const FieldDescriptor* field) {
+  return field->is_repeated() && !field->is_map() &&
+         field->cpp_type() != FieldDescriptor::CPPTYPE_STRING &&
+         field->cpp_type() != FieldDescriptor::CPPTYPE_MESSAGE;
+}
+
+// Collects the fields set in a pure python message of the type `descriptor`.
+// Returns false when the message cannot be copied field by field: it has
+// extensions or unknown fields, which ListFields() omits, or is not a pure
+// python message. `cost` is incremented by the number of fields plus the
+// number of elements of repeated numeric fields.
+bool CollectPyFields(py::handle py_proto, const Descriptor* descriptor,
+                     std::vector<PyField>* fields, size_t* cost) {
+  // Only pure python messages keep their unknown fields in this attribute.
+  auto unknown_fields = ResolveAttrs(py_proto, {"_unknown_fields"});
+  if (!unknown_fields || py::len(*unknown_fields) != 0) return false;
+  auto list_fields = ResolveAttrMRO(py_proto, "ListFields");
+  if (!list_fields) return false;
+  for (py::handle item : (*list_fields)()) {
+    auto field_and_value = py::reinterpret_borrow<py::tuple>(item);
+    py::handle py_field = field_and_value[0];
+    if (py_field.attr("is_extension").cast<bool>()) return false;
+    const FieldDescriptor* field =
+        descriptor->FindFieldByNumber(py_field.attr("number").cast<int>());
+    if (field == nullptr) return false;
+    py::object value = field_and_value[1];
+    ++*cost;
+    if (IsRepeatedNumeric(field)) *cost += py::len(value);
+    fields->push_back({field, std::move(value)});
+  }
+  return true;
+}
+
+bool CopyPyFields(const std::vector<PyField>& fields, Message* message);
+
+// Copies a python submessage field by field, or from the wire format when it
+// cannot be copied that way.
+bool CopyPySubmessage(py::handle py_proto, Message* message) {
+  std::vector<PyField> fields;
+  size_t cost = 0;
+  if (CollectPyFields(py_proto, message->GetDescriptor(), &fields, &cost)) {
+    return CopyPyFields(fields, message);
+  }
+  auto serialize_fn = ResolveAttrMRO(py_proto, "SerializePartialToString");
+  if (!serialize_fn) return false;
+  auto wire = (*serialize_fn)();
+  const char* bytes = PYBIND11_BYTES_AS_STRING(wire.ptr());
+  if (!bytes) {
+    PyErr_Clear();
+    return false;
+  }
+  return message->ParsePartialFromArray(
+      bytes, static_cast<int>(PYBIND11_BYTES_SIZE(wire.ptr())));
+}
+
+template <typename T>
+void SetOrAddValue(Message* message, const FieldDescriptor* field, T value,
+                   void (Reflection::*set)(Message*, const FieldDescriptor*,
+                                           T) const,
+                   void (Reflection::*add)(Message*, const FieldDescriptor*,
+                                           T) const) {
+  const Reflection* reflection = message->GetReflection();
+  if (field->is_repeated()) {
+    (reflection->*add)(message, field, std::move(value));
+  } else {
+    (reflection->*set)(message, field, std::move(value));
+  }
+}
+
+// Sets `field` of `message`, or adds an element to it when repeated, from a
+// python value. Throws a cast_error when the value has the wrong type.
+bool SetPyValue(Message* message, const FieldDescriptor* field,
+                py::handle value) {
+  switch (field->cpp_type()) {
+    case FieldDescriptor::CPPTYPE_INT32:
+      SetOrAddValue(message, field, value.cast<int32_t>(),
+                    &Reflection::SetInt32, &Reflection::AddInt32);
+      return true;
+    case FieldDescriptor::CPPTYPE_INT64:
+      SetOrAddValue(message, field, value.cast<int64_t>(),
+                    &Reflection::SetInt64, &Reflection::AddInt64);
+      return true;
+    case FieldDescriptor::CPPTYPE_UINT32:
+      SetOrAddValue(message, field, value.cast<uint32_t>(),
+                    &Reflection::SetUInt32, &Reflection::AddUInt32);
+      return true;
+    case FieldDescriptor::CPPTYPE_UINT64:
+      SetOrAddValue(message, field, value.cast<uint64_t>(),
+                    &Reflection::SetUInt64, &Reflection::AddUInt64);
+      return true;
+    case FieldDescriptor::CPPTYPE_DOUBLE:
+      SetOrAddValue(message, field, value.cast<double>(),
+                    &Reflection::SetDouble, &Reflection::AddDouble);
+      return true;
+    case FieldDescriptor::CPPTYPE_FLOAT:
+      SetOrAddValue(message, field, value.cast<float>(), &Reflection::SetFloat,
+                    &Reflection::AddFloat);
+      return true;
+    case FieldDescriptor::CPPTYPE_BOOL:
+      SetOrAddValue(message, field, value.cast<bool>(), &Reflection::SetBool,
+                    &Reflection::AddBool);
+      return true;
+    case FieldDescriptor::CPPTYPE_ENUM:
+      // Closed enums keep unknown values in the unknown fields, as parsing
+      // would.
+      SetOrAddValue(message, field, value.cast<int>(),
+                    &Reflection::SetEnumValue, &Reflection::AddEnumValue);
+      return true;
+    case FieldDescriptor::CPPTYPE_STRING:
+      // Casts both str, for string fields, and bytes.
+      SetOrAddValue(message, field, value.cast<std::string>(),
+                    &Reflection::SetString, &Reflection::AddString);
+      return true;
+    case FieldDescriptor::CPPTYPE_MESSAGE: {
+      const Reflection* reflection = message->GetReflection();
+      return CopyPySubmessage(value, field->is_repeated()
+                                         ? reflection->AddMessage(message, field)
+                                         : reflection->MutableMessage(message,
+                                                                      field));
+    }
+  }
+  return false;
+}
+
+// Appends the elements of a python sequence to a repeated numeric field,
+// converting them in C++.
+template <typename T>
+void AddPyElements(Message* message, const FieldDescriptor* field,
+                   py::handle values) {
+  auto repeated =
+      message->GetReflection()->GetMutableRepeatedFieldRef<T>(message, field);
+  for (py::handle value : values) repeated.Add(value.cast<T>());
+}
+
+// Copies the fields collected by CollectPyFields() into `message`, which is
+// cleared first.
+bool CopyPyFields(const std::vector<PyField>& fields, Message* message) {
+  message->Clear();
+  for (const PyField& py_field : fields) {
+    const FieldDescriptor* field = py_field.field;
+    if (field->is_map()) {
+      // Map entries are messages holding a key and a value.
+      const FieldDescriptor* key_field = field->message_type()->map_key();
+      const FieldDescriptor* value_field = field->message_type()->map_value();
+      for (py::handle item : py_field.value.attr("items")()) {
+        auto key_and_value = py::reinterpret_borrow<py::tuple>(item);
+        Message* entry = message->GetReflection()->AddMessage(message, field);
+        if (!SetPyValue(entry, key_field, key_and_value[0]) ||
+            !SetPyValue(entry, value_field, key_and_value[1])) {
+          return false;
+        }
+      }
+      continue;
+    }
+    if (!field->is_repeated()) {
+      if (!SetPyValue(message, field, py_field.value)) return false;
+      continue;
+    }
+    switch (field->cpp_type()) {
+      case FieldDescriptor::CPPTYPE_INT32:
+        AddPyElements<int32_t>(message, field, py_field.value);
+        break;
+      case FieldDescriptor::CPPTYPE_INT64:
+        AddPyElements<int64_t>(message, field, py_field.value);
+        break;
+      case FieldDescriptor::CPPTYPE_UINT32:
+        AddPyElements<uint32_t>(message, field, py_field.value);
+        break;
+      case FieldDescriptor::CPPTYPE_UINT64:
+        AddPyElements<uint64_t>(message, field, py_field.value);
+        break;
+      case FieldDescriptor::CPPTYPE_DOUBLE:
+        AddPyElements<double>(message, field, py_field.value);
+        break;
+      case FieldDescriptor::CPPTYPE_FLOAT:
+        AddPyElements<float>(message, field, py_field.value);
+        break;
+      case FieldDescriptor::CPPTYPE_BOOL:
+        AddPyElements<bool>(message, field, py_field.value);
+        break;
+      default:
+        for (py::handle value : py_field.value) {
+          if (!SetPyValue(message, field, value)) return false;
+        }
+    }
+  }
+  return true;
+}
+
+// Copies a large pure python message field by field; see kMinFieldCopyCost.
+// Returns false, so that the caller uses the wire format, when the message
+// is too small or cannot be copied that way.
+bool MaybeCopyPyFields(py::handle py_proto, Message* message) {
+  try {
+    std::vector<PyField> fields;
+    size_t cost = 0;
+    return CollectPyFields(py_proto, message->GetDescriptor(), &fields,
+                           &cost) &&
+           cost >= kMinFieldCopyCost && CopyPyFields(fields, message);
+  } catch (const py::cast_error&) {
+    // A value of an unexpected type; the wire format reports any error.
+  } catch (const py::error_already_set&) {
+    // Also dropped, as it is raised again by the serialization if relevant.
+  }
+  // Parsing the wire format clears anything copied before the failure.
+  return false;
+}
+
+// The threads which help PyProtoCopyToCProtosInParallel(). They are started
+// on first use, up to the largest number requested, and wait for work between
+// calls. Like the other process-wide state of this file, the pool is leaked,
+// and its threads are never joined.
+class ParallelLoadPool {
+ public:
+  static ParallelLoadPool* instance() {
+    static auto* pool = new ParallelLoadPool();
+    return pool;
+  }
+
+  // Runs `fn` on the calling thread and on up to `helpers` pool threads, and
+  // returns once every started run has returned. `fn` must return promptly
+  // once its work has been claimed by others, as pool threads may start it
+  // late when they are busy with other calls. Runs which have not started by
+  // the time the calling thread is done are dropped, so calls also complete
+  // when the pool threads are gone, as in a forked child.
+  void Run(size_t helpers, const std::function<void()>& fn) {
+    Task task{&fn, 0};
+    {
+      absl::MutexLock lock(&mutex_);
+      while (threads_ < helpers) {
+        try {
+          std::thread(&ParallelLoadPool::Work, this).detach();
+        } catch (const std::system_error&) {
+          // Make do with the threads already started.
+          break;
+        }
+        ++threads_;
+      }
+      task.pending = std::min(helpers, threads_);
+      for (size_t i = 0; i < task.pending; ++i) queue_.push_back(&task);
+    }
+    fn();
+    absl::MutexLock lock(&mutex_);
+    // Runs not yet started are no longer needed.
+    size_t queued = queue_.size();
+    queue_.erase(std::remove(queue_.begin(), queue_.end(), &task),
+                 queue_.end());
+    task.pending -= queued - queue_.size();
+    mutex_.Await(absl::Condition(
+        +[](Task* t) { return t->pending == 0; }, &task));
+  }
+
+ private:
+  struct Task {
+    const std::function<void()>* fn;
+    // Runs queued or in progress, guarded by mutex_.
+    size_t pending;
+  };
+
+  ParallelLoadPool() = default;
+
+  void Work() {
+    for (;;) {
+      Task* task;
+      {
+        absl::MutexLock lock(&mutex_);
+        mutex_.Await(absl::Condition(
+            +[](std::deque<Task*>* queue) { return !queue->empty(); },
+            &queue_));
+        task = queue_.front();
+        queue_.pop_front();
+      }
+      (*task->fn)();
+      absl::MutexLock lock(&mutex_);
+      --task->pending;
+    }
+  }
+
+  absl::Mutex mutex_;
+  std::deque<Task*> queue_ ABSL_GUARDED_BY(mutex_);
+  size_t threads_ ABSL_GUARDED_BY(mutex_) = 0;
+};
+
+}  // namespace
+
 bool PyProtoCopyToCProto(py::handle py_proto, Message* message) {
   assert(PyGILState_Check());
+  ScopedCastTimer timer(message->GetDescriptor());
+  // When py_proto is backed by a C++ message from a compatible runtime, copy
+  // between the C++ messages directly rather than through a python bytes
+  // object.
+  if (const Message* src = PyProtoGetCppMessagePointer(py_proto)) {
+    return CProtoCopyToCProto(*src, message);
+  }
+  if (GlobalState::instance()->using_pure_python() &&
+      MaybeCopyPyFields(py_proto, message)) {
+    RecordCastPath(message->GetDescriptor(), kFieldCopy);
+    return true;
+  }
+
   auto serialize_fn = ResolveAttrMRO(py_proto, "SerializePartialToString");
   if (!serialize_fn) {
     throw py::type_error(
@@ -661,10 +1770,86 @@ bool PyProtoCopyToCProto(py::handle py_proto, Message* message) {
     throw py::type_error("SerializePartialToString failed; is this a " +
                          message->GetDescriptor()->full_name());
   }
-  return message->ParsePartialFromArray(bytes, PYBIND11_BYTES_SIZE(wire.ptr()));
+  RecordCastPath(message->GetDescriptor(), kSerialize,
+                 PYBIND11_BYTES_SIZE(wire.ptr()));
+  // wire holds a reference to the immutable bytes object, which keeps the
+  // buffer valid if the GIL is released.
+  return ParsePartialMaybeReleasingGil(message, bytes,
+                                       PYBIND11_BYTES_SIZE(wire.ptr()));
 }
 
-void CProtoCopyToPyProto(Message* message, py::handle py_proto) {
+bool PyProtoCopyToCProtosInParallel(py::sequence py_protos,
+                                    Message* const* messages) {
+  assert(PyGILState_Check());
+  const size_t size = py_protos.size();
+
+  // Serialized python protos, held until parsed, and their contents.
+  std::vector<py::object> wires(size);
+  std::vector<absl::string_view> wire_views(size);
+  for (size_t i = 0; i < size; ++i) {
+    py::object py_proto = py_protos[i];
+    Message* message = messages[i];
+    const Message* src = PyProtoViewGetCppMessagePointer(py_proto);
+    if (!src) src = PyProtoGetCppMessagePointer(py_proto);
+    if (src && src->GetDescriptor() == message->GetDescriptor()) {
+      RecordCastPath(message->GetDescriptor(), kCopyFrom);
+      message->CopyFrom(*src);
+      continue;
+    }
+    if (!PyProtoIsCompatible(py_proto, message->GetDescriptor())) {
+      return false;
+    }
+    auto serialize_fn = ResolveAttrMRO(py_proto, "SerializePartialToString");
+    if (!serialize_fn) {
+      throw py::type_error(
+          "SerializePartialToString method not found; is this a " +
+          message->GetDescriptor()->full_name());
+    }
+    wires[i] = (*serialize_fn)();
+    const char* bytes = PYBIND11_BYTES_AS_STRING(wires[i].ptr());
+    if (!bytes) {
+      throw py::type_error("SerializePartialToString failed; is this a " +
+                           message->GetDescriptor()->full_name());
+    }
+    wire_views[i] =
+        absl::string_view(bytes, PYBIND11_BYTES_SIZE(wires[i].ptr()));
+    if (wire_views[i].size() > static_cast<size_t>(INT_MAX)) {
+      throw py::value_error("Message too large to parse: " +
+                            message->GetDescriptor()->full_name());
+    }
+    RecordCastPath(message->GetDescriptor(), kSerialize, wire_views[i].size());
+  }
+
+  // This thread and the pool threads claim batches until none are left.
+  const size_t batch_size = std::max<size_t>(
+      1, parallel_load_batch_size.load(std::memory_order_relaxed));
+  const size_t batches = (size + batch_size - 1) / batch_size;
+  const size_t threads = std::min<size_t>(
+      batches,
+      std::max(1, parallel_load_threads.load(std::memory_order_relaxed)));
+  std::atomic<size_t> next_batch{0};
+  std::atomic<bool> ok{true};
+  std::function<void()> parse_batches = [&] {
+    for (size_t batch = next_batch.fetch_add(1); batch < batches;
+         batch = next_batch.fetch_add(1)) {
+      if (!ok.load(std::memory_order_relaxed)) return;
+      const size_t end = std::min(size, (batch + 1) * batch_size);
+      for (size_t i = batch * batch_size; i < end; ++i) {
+        if (!wires[i]) continue;
+        if (!messages[i]->ParsePartialFromArray(
+                wire_views[i].data(), static_cast<int>(wire_views[i].size()))) {
+          ok.store(false, std::memory_order_relaxed);
+        }
+      }
+    }
+  };
+
+  py::gil_scoped_release release;
+  ParallelLoadPool::instance()->Run(threads - 1, parse_batches);
+  return ok.load();
+}
+
+void CProtoCopyToPyProto(Message* message, py::handle py_proto, bool owned) {
   assert(PyGILState_Check());
   auto merge_fn = ResolveAttrMRO(py_proto, "MergeFromString");
   if (!merge_fn) {
@@ -672,7 +1857,8 @@ void CProtoCopyToPyProto(Message* message, py::handle py_proto) {
                          message->GetDescriptor()->full_name());
   }
 
-  auto serialized = message->SerializePartialAsString();
+  auto serialized = SerializePartialMaybeReleasingGil(*message, owned);
+  RecordCastPath(message->GetDescriptor(), kSerialize, serialized.size());
 #if PY_MAJOR_VERSION >= 3
   auto view = py::memoryview::from_memory(serialized.data(), serialized.size());
 #else
@@ -684,7 +1870,38 @@ void CProtoCopyToPyProto(Message* message, py::handle py_proto) {
 std::unique_ptr<Message> AllocateCProtoFromPythonSymbolDatabase(
     py::handle src, const std::string& full_name) {
   assert(PyGILState_Check());
-  auto pool = ResolveAttrs(src, {"DESCRIPTOR", "file", "pool"});
+  auto py_descriptor = ResolveAttrs(src, {"DESCRIPTOR"});
+  if (!py_descriptor) {
+    throw py::type_error("Object is not a valid protobuf");
+  }
+
+  // When the python backend shares its C++ runtime with this CU, its
+  // descriptors are C++ descriptors of the generated pool or of the pool
+  // behind python's default pool. Use those rather than rebuilding the type
+  // in a wrapped pool.
+  GlobalState* state = GlobalState::instance();
+  if (state->abi_compatible()) {
+    const PyProto_API* py_proto_api = state->py_proto_api();
+    const Descriptor* descriptor =
+        py_proto_api->MessageDescriptor_AsDescriptor(py_descriptor->ptr());
+    if (descriptor == nullptr) {
+      PyErr_Clear();
+    } else if (descriptor->full_name() == full_name) {
+      const DescriptorPool* shared_pool = descriptor->file()->pool();
+      MessageFactory* factory = nullptr;
+      if (shared_pool == DescriptorPool::generated_pool()) {
+        factory = MessageFactory::generated_factory();
+      } else if (shared_pool == py_proto_api->GetDefaultDescriptorPool()) {
+        factory = py_proto_api->GetDefaultMessageFactory();
+      }
+      if (const Message* prototype =
+              factory ? factory->GetPrototype(descriptor) : nullptr) {
+        return std::unique_ptr<Message>(prototype->New());
+      }
+    }
+  }
+
+  auto pool = ResolveAttrs(*py_descriptor, {"file", "pool"});
   if (!pool) {
     throw py::type_error("Object is not a valid protobuf");
   }
@@ -737,6 +1954,46 @@ std::string ReturnValuePolicyName(py::return_value_policy policy) {
   }
 }
 
+// Moves or copies src into the C++ message owned by a fast_cpp_proto.
+void CProtoTransferToFastCppProto(Message* src, Message* dst, bool move) {
+  if (dst->GetReflection() == src->GetReflection()) {
+    // The internals may be Swapped or copied iff the protos use the same
+    // Reflection instance.
+    if (move) {
+      RecordCastPath(dst->GetDescriptor(), kSwap);
+      dst->GetReflection()->Swap(src, dst);
+    } else {
+      RecordCastPath(dst->GetDescriptor(), kCopyFrom);
+      dst->CopyFrom(*src);
+    }
+  } else if (dst->GetDescriptor() == src->GetDescriptor()) {
+    // The same type with a different Reflection, for example a DynamicMessage
+    // from a caller's DynamicMessageFactory and one from the python factory.
+    // Swap is not allowed, but the reflection based copy avoids a round trip
+    // through the wire format. The python message cannot adopt src itself:
+    // NewMessageOwnedExternally has no way to release src when the python
+    // object is destroyed.
+    RecordCastPath(dst->GetDescriptor(), kCopyFrom);
+    dst->CopyFrom(*src);
+  } else {
+    // dst is not yet visible to other python threads; src is only safe to
+    // serialize without the GIL when it is being moved.
+    auto serialized = SerializePartialMaybeReleasingGil(*src, move);
+    RecordCastPath(dst->GetDescriptor(), kSerialize, serialized.size());
+    bool parsed;
+    if (ShouldReleaseGil(serialized.size())) {
+      py::gil_scoped_release release;
+      parsed = dst->ParseFromString(serialized);
+    } else {
+      parsed = dst->ParseFromString(serialized);
+    }
+    if (!parsed) {
+      throw py::type_error(
+          "Failed to copy protocol buffer with mismatched descriptor");
+    }
+  }
+}
+
 }  // namespace
 
 py::handle GenericPyProtoCast(Message* src, py::return_value_policy policy,
@@ -746,7 +2003,9 @@ py::handle GenericPyProtoCast(Message* src, py::return_value_policy policy,
   auto py_proto =
       GlobalState::instance()->PyMessageInstance(src->GetDescriptor());
 
-  CProtoCopyToPyProto(src, py_proto);
+  bool owned = policy == py::return_value_policy::move ||
+               policy == py::return_value_policy::take_ownership;
+  CProtoCopyToPyProto(src, py_proto, owned);
   return py_proto.release();
 }
 
@@ -767,17 +2026,7 @@ py::handle GenericFastCppProtoCast(Message* src, py::return_value_policy policy,
       py::object& result = descriptor_pair.first;
       Message* result_message = descriptor_pair.second;
 
-      if (result_message->GetReflection() == src->GetReflection()) {
-        // The internals may be Swapped iff the protos use the same Reflection
-        // instance.
-        result_message->GetReflection()->Swap(src, result_message);
-      } else {
-        auto serialized = src->SerializePartialAsString();
-        if (!result_message->ParseFromString(serialized)) {
-          throw py::type_error(
-              "Failed to copy protocol buffer with mismatched descriptor");
-        }
-      }
+      CProtoTransferToFastCppProto(src, result_message, /*move=*/true);
       return result.release();
     } break;
 
@@ -792,23 +2041,14 @@ py::handle GenericFastCppProtoCast(Message* src, py::return_value_policy policy,
       py::object& result = descriptor_pair.first;
       Message* result_message = descriptor_pair.second;
 
-      if (result_message->GetReflection() == src->GetReflection()) {
-        // The internals may be copied iff the protos use the same Reflection
-        // instance.
-        result_message->CopyFrom(*src);
-      } else {
-        auto serialized = src->SerializePartialAsString();
-        if (!result_message->ParseFromString(serialized)) {
-          throw py::type_error(
-              "Failed to copy protocol buffer with mismatched descriptor");
-        }
-      }
+      CProtoTransferToFastCppProto(src, result_message, /*move=*/false);
       return result.release();
     } break;
 
     case py::return_value_policy::reference:
     case py::return_value_policy::reference_internal: {
       // NOTE: Reference to const are currently unsafe to return.
+      RecordCastPath(src->GetDescriptor(), kBorrow);
       py::object result = py::reinterpret_steal<py::object>(
           GlobalState::instance()->py_proto_api()->NewMessageOwnedExternally(
               src, nullptr));
@@ -828,6 +2068,7 @@ py::handle GenericProtoCast(Message* src, py::return_value_policy policy,
                             py::handle parent, bool is_const) {
   assert(src != nullptr);
   assert(PyGILState_Check());
+  ScopedCastTimer timer(src->GetDescriptor());
 
   // Return a native python-allocated proto when:
   // 1. The binary does not have a py_proto_api instance, or
@@ -840,6 +2081,7 @@ py::handle GenericProtoCast(Message* src, py::return_value_policy policy,
     return GenericPyProtoCast(src, policy, parent, is_const);
   }
 
+  RecordCastPath(src->GetDescriptor(), kUnknownFieldCheck);
   std::optional<std::string> emsg =
       check_unknown_fields::CheckAndBuildErrorMessageIfAny(
           GlobalState::instance()->py_proto_api(), src);
@@ -853,4 +2095,74 @@ py::handle GenericProtoCast(Message* src, py::return_value_policy policy,
   return GenericFastCppProtoCast(src, policy, parent, is_const);
 }
 
+py::handle GenericProtoListCast(const Descriptor* descriptor,
+                                Message* const* src, size_t size,
+                                bool move) {
+  assert(descriptor != nullptr);
+  assert(PyGILState_Check());
+  GlobalState* state = GlobalState::instance();
+  py::list result(size);
+  if (size == 0) return result.release();
+
+  // Same dispatch as GenericProtoCast, decided once for the whole batch.
+  if ((state->py_proto_api() == nullptr) ||
+      (descriptor->file()->pool() == DescriptorPool::generated_pool() &&
+       !state->using_fast_cpp())) {
+    py::object py_class = state->PyMessageClass(descriptor);
+    for (size_t i = 0; i < size; ++i) {
+      py::object py_proto;
+      if (src[i]->GetDescriptor() == descriptor) {
+        py_proto = py_class();
+        CProtoCopyToPyProto(src[i], py_proto, move);
+      } else {
+        py_proto = py::reinterpret_steal<py::object>(GenericProtoCast(
+            src[i], py::return_value_policy::copy, py::handle(), false));
+      }
+      PyList_SET_ITEM(result.ptr(), static_cast<ssize_t>(i),
+                      py_proto.release().ptr());  // steals a reference
+    }
+    return result.release();
+  }
+
+  // The first instance comes from (and populates) the pool and class caches;
+  // the remaining ones are constructed directly from its class.
+  py::handle py_class;
+  for (size_t i = 0; i < size; ++i) {
+    if (src[i]->GetDescriptor() != descriptor) {
+      // Only reachable for containers of ::google::protobuf::Message.
+      py::handle py_proto = GenericProtoCast(
+          src[i],
+          move ? py::return_value_policy::move : py::return_value_policy::copy,
+          py::handle(), false);
+      PyList_SET_ITEM(result.ptr(), static_cast<ssize_t>(i), py_proto.ptr());
+      continue;
+    }
+    RecordCastPath(descriptor, kUnknownFieldCheck);
+    std::optional<std::string> emsg =
+        check_unknown_fields::CheckAndBuildErrorMessageIfAny(
+            state->py_proto_api(), src[i]);
+    if (emsg) {
+      throw py::value_error(*emsg);
+    }
+
+    py::object py_proto;
+    Message* message;
+    if (!py_class) {
+      std::tie(py_proto, message) =
+          state->PyFastCppProtoMessageInstance(descriptor);
+      py_class = py::type::handle_of(py_proto);
+    } else {
+      py_proto = py_class();
+      message = state->py_proto_api()->GetMutableMessagePointer(py_proto.ptr());
+      if (message == nullptr) {
+        throw py::error_already_set();
+      }
+    }
+    CProtoTransferToFastCppProto(src[i], message, move);
+    PyList_SET_ITEM(result.ptr(), static_cast<ssize_t>(i),
+                    py_proto.release().ptr());  // steals a reference
+  }
+  return result.release();
+}
+
 }  // namespace pybind11_protobuf
@@ -6,11 +6,13 @@
 #include <pybind11/pybind11.h>
 #include <pybind11/pytypes.h>
 
+#include <cstddef>
 #include <functional>
 #include <memory>
 #include <string>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 #include "google/protobuf/descriptor.h"
 #include "google/protobuf/message.h"
@@ -24,18 +26,98 @@
 // compatible between all involved Python extensions:
 // * Protobuf library versions.
 // * Compiler/linker & compiler/linker options.
+//
+// Without the define, the same optimization is enabled at runtime when the
+// PyProto_API reports the same protobuf version and resolves compiled-in
+// descriptors to the same instances as this extension, i.e. when both
+// share a single protobuf runtime and generated_pool().
 // #define PYBIND11_PROTOBUF_ASSUME_FULL_ABI_COMPATIBILITY
 
+namespace google::protobuf::python {
+struct PyProto_API;
+}  // namespace google::protobuf::python
+
 namespace pybind11_protobuf {
 
 // Initialize internal proto cast dependencies, which includes importing
 // various protobuf-related modules.
 void InitializePybindProtoCastUtil();
 
+// Returns the PyProto_API used by the casters, or nullptr when it is not
+// available: the casters were built without
+// PYBIND11_PROTOBUF_ENABLE_PYPROTO_API, the python protobuf backend does not
+// provide it, or its version does not match. GenericFastCppProtoCast()
+// requires it.
+const ::google::protobuf::python::PyProto_API *GetPyProtoApi();
+
 // Imports a module pertaining to a given ::google::protobuf::Descriptor, if possible.
 void ImportProtoDescriptorModule(const ::google::protobuf::Descriptor *);
 
-// Returns a ::google::protobuf::Message* from a cpp_fast_proto, if backed by C++.
+// Resolves and caches the python message class for a compiled-in descriptor,
+// so that later C++ -> python casts of that type skip the lookup. Throws a
+// type_error when the class cannot be found.
+void PreloadPyMessageClass(const ::google::protobuf::Descriptor *);
+
+// Like PreloadPyMessageClass(), for several descriptors: the python module of
+// each file is imported once, then the classes are resolved from the
+// imported modules. Throws a type_error for the first class not found.
+void PreloadPyMessageClasses(
+    const std::vector<const ::google::protobuf::Descriptor *> &descriptors);
+
+// Sets the wire size, in bytes, at or above which proto parsing and
+// serialization done while converting between python and C++ release the GIL.
+// Zero, the default, keeps the GIL held throughout. C++ messages are only
+// serialized without the GIL when their ownership passes to python, since
+// other messages may be mutated by python threads through their bindings.
+void SetGilReleaseThreshold(size_t bytes);
+
+// Configures PyProtoCopyToCProtosInParallel(), used to load sequences of at
+// least two batches of `batch_size` python protos into a std::vector<Proto>,
+// on up to `max_threads` threads. `max_threads` below 2, the default,
+// disables parallel loading.
+void SetParallelLoad(size_t batch_size, int max_threads);
+
+// Whether loading `size` python protos should use
+// PyProtoCopyToCProtosInParallel(); see SetParallelLoad().
+bool UseParallelLoad(size_t size);
+
+// Conversion statistics of the casters linked into this extension module,
+// disabled by default. When enabled, each conversion records, by message
+// full_name, which path it took:
+// * borrow: a C++ message held by a python object was used in place, or a
+//   C++ message was returned by reference;
+// * swap and copy_from: messages were moved or copied in C++;
+// * serialize: the message went through the wire format, whose size is
+//   added to bytes;
+// * field_copy: a pure python message was copied field by field;
+// * unknown_field_check: the message was checked for unknown fields.
+// Single message conversions also add their duration to latency_us, a list
+// of counts of conversions under 1us, then in [2**(i-1), 2**i) us.
+// While disabled, recording costs a relaxed atomic load.
+void EnableCasterStats(bool enabled);
+void ResetCasterStats();
+// Returns {full_name: {path: count, "bytes": int, "latency_us": [int]}}.
+pybind11::dict GetCasterStats();
+
+// Like the above, for all the extension modules of this interpreter whose
+// casters have been initialized. Modules initialized after
+// EnableAllCasterStats(true) start enabled. These back the
+// pybind11_protobuf.caster_stats module.
+void EnableAllCasterStats(bool enabled);
+void ResetAllCasterStats();
+pybind11::dict GetAllCasterStats();
+
+// Records a borrow or a copy made by the casters outside of this file.
+void RecordCasterBorrow(const ::google::protobuf::Message &message);
+void RecordCasterCopy(const ::google::protobuf::Message &message);
+
+// Drops the python DescriptorPool and message classes cached for a C++
+// DescriptorPool by C++ -> python casts of its messages. Must be called
+// before such a pool is deallocated.
+void ReleasePyDescriptorPool(const ::google::protobuf::DescriptorPool *);
+
+// Returns a ::google::protobuf::Message* from a cpp_fast_proto, if backed by C++
+// and the underlying protobuf runtime is known to be ABI compatible.
 const ::google::protobuf::Message *PyProtoGetCppMessagePointer(pybind11::handle src);
 
 // Returns the protocol buffer's py_proto.DESCRIPTOR.full_name attribute.
@@ -54,8 +136,28 @@ std::unique_ptr<::google::protobuf::Message> AllocateCProtoFromPythonSymbolDatab
 
 // Serialize the py_proto and deserialize it into the provided message.
 // Caller should enforce any type identity that is required.
+// With the pure python backend, large messages, by number of set fields plus
+// repeated numeric elements, are instead copied field by field, as long as
+// they have no extensions or unknown fields.
 bool PyProtoCopyToCProto(pybind11::handle py_proto, ::google::protobuf::Message *message);
-void CProtoCopyToPyProto(::google::protobuf::Message *message, pybind11::handle py_proto);
+
+// Serializes message and merges it into py_proto. `owned` indicates that
+// message is owned by the caller and not reachable from python, for example
+// when it is being moved to python; only then may large messages be
+// serialized with the GIL released (see SetGilReleaseThreshold).
+void CProtoCopyToPyProto(::google::protobuf::Message *message, pybind11::handle py_proto,
+                         bool owned = false);
+
+// Copies each element of `py_protos` into the corresponding message of
+// `messages`, which has at least as many elements. Python protos are first
+// serialized with the GIL held, then parsed with the GIL released, in batches
+// spread over the threads set by SetParallelLoad(). Elements backed by a
+// compatible C++ message are copied directly, with the GIL held, since python
+// code could otherwise modify them concurrently.
+// Returns false when an element is not compatible with the type of its
+// message (see PyProtoIsCompatible) or fails to parse.
+bool PyProtoCopyToCProtosInParallel(pybind11::sequence py_protos,
+                                    ::google::protobuf::Message *const *messages);
 
 // Returns a handle to a python protobuf suitably
 pybind11::handle GenericFastCppProtoCast(::google::protobuf::Message *src,
@@ -71,6 +173,14 @@ pybind11::handle GenericProtoCast(::google::protobuf::Message *src,
                                   pybind11::return_value_policy policy,
                                   pybind11::handle parent, bool is_const);
 
+// Converts `size` C++ protos, usually all of type `descriptor`, into a python
+// list. The conversion path and python message class are resolved once for
+// the batch rather than per element. When `move` is true the contents of src may
+// be swapped into the python messages.
+pybind11::handle GenericProtoListCast(
+    const ::google::protobuf::Descriptor *descriptor,
+    ::google::protobuf::Message *const *src, size_t size, bool move);
+
 }  // namespace pybind11_protobuf
 
 #endif  // PYBIND11_PROTOBUF_PROTO_CAST_UTIL_H_
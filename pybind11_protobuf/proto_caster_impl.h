@@ -8,17 +8,21 @@
 #include <pybind11/pybind11.h>
 #include <pybind11/pytypes.h>
 
+#include <cstddef>
 #include <functional>
 #include <memory>
 #include <optional>
 #include <string>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
+#include "google/protobuf/arena.h"
 #include "google/protobuf/descriptor.pb.h"
 #include "google/protobuf/descriptor.h"
 #include "google/protobuf/message.h"
 #include "pybind11_protobuf/proto_cast_util.h"
+#include "pybind11_protobuf/proto_view.h"
 
 // Enables unsafe conversions; currently these are a work in progress.
 #if !defined(PYBIND11_PROTOBUF_UNSAFE)
@@ -27,6 +31,169 @@
 
 namespace pybind11_protobuf {
 
+// ADL function to opt into arena allocation of the temporary messages created
+// when loading a ProtoType from python. Defaults to disabled. To allocate
+// those temporaries from a ::google::protobuf::Arena held by the caster, define a
+// constexpr function in the same namespace as the proto, like:
+//
+//  constexpr bool pybind11_protobuf_use_load_arena(MyProto*) { return true; }
+//
+// All allocations made while parsing the temporary (submessages, strings,
+// repeated fields) are then released in one shot when the call returns.
+// The arenas are reused by later calls on the same thread; see
+// load_arena_pool. This is best suited to protos passed by const reference or
+// const pointer; by-value, rvalue and std::unique_ptr parameters need a
+// heap-owned message and will copy out of the arena.
+constexpr bool pybind11_protobuf_use_load_arena(...) { return false; }
+
+template <typename ProtoType>
+constexpr bool load_arena_enabled() {
+  return pybind11_protobuf_use_load_arena(static_cast<ProtoType *>(nullptr));
+}
+
+// The per-thread free list of arenas of pybind11_protobuf_use_load_arena, used
+// as the deleter of the arena held by a caster for the duration of a call.
+// Each arena starts on its own initial block, so loads of messages which fit
+// in it do not allocate; Reset() frees any further blocks when the arena goes
+// back to the list.
+struct load_arena_pool {
+  static constexpr size_t kInitialBlockSize = 8192;
+  static constexpr size_t kMaxFreeArenas = 4;
+
+  struct arena_with_block {
+    arena_with_block() : arena(block, sizeof(block)) {}
+
+    alignas(std::max_align_t) char block[kInitialBlockSize];
+    ::google::protobuf::Arena arena;
+  };
+
+  static arena_with_block *acquire() {
+    auto &list = free_list();
+    if (list.empty()) return new arena_with_block();
+    arena_with_block *arena = list.back().release();
+    list.pop_back();
+    return arena;
+  }
+
+  void operator()(arena_with_block *arena) const {
+    auto &list = free_list();
+    if (list.size() >= kMaxFreeArenas) {
+      delete arena;
+      return;
+    }
+    arena->arena.Reset();
+    list.emplace_back(arena);
+  }
+
+ private:
+  static std::vector<std::unique_ptr<arena_with_block>> &free_list() {
+    thread_local std::vector<std::unique_ptr<arena_with_block>> list;
+    return list;
+  }
+};
+
+// ADL function to opt into read-only views for const ProtoType references
+// returned with return_value_policy::reference or reference_internal, which
+// otherwise return a copy. To enable them, define a constexpr function in the
+// same namespace as the proto, like:
+//
+//  constexpr bool pybind11_protobuf_enable_read_only_views(MyProto*)
+//  { return true; }
+//
+// The returned python object reads fields directly from the C++ message; it
+// raises AttributeError on assignment, and view.materialize() returns a
+// regular python message. With reference_internal the view keeps its parent
+// alive, as for py::class_-wrapped types. Views may be passed back to C++
+// functions accepting ProtoType, which then use the C++ message directly.
+//
+// This also makes std::shared_ptr<const ProtoType> returns share ownership of
+// the message with a view instead of copying it; passing such a view to a
+// std::shared_ptr<const ProtoType> parameter returns the original pointer.
+constexpr bool pybind11_protobuf_enable_read_only_views(...) { return false; }
+
+template <typename ProtoType>
+constexpr bool read_only_views_enabled() {
+  return pybind11_protobuf_enable_read_only_views(
+      static_cast<ProtoType *>(nullptr));
+}
+
+// ADL function to opt into lazy conversion of ProtoType messages whose
+// ownership passes to python: returns by value, rvalue or std::unique_ptr, and
+// pointers returned with return_value_policy::take_ownership. To enable it,
+// define a constexpr function in the same namespace as the proto, like:
+//
+//  constexpr bool pybind11_protobuf_enable_lazy_conversion(MyProto*)
+//  { return true; }
+//
+// The returned python object holds the moved C++ message and reads singular
+// fields from it; it is converted into a regular python message when needed,
+// such as on assignment, isinstance() or most message methods, see
+// GenericProtoLazyCast(). Until then, passing it back to a C++ function
+// accepting ProtoType uses the C++ message directly. isinstance() sees the
+// class of the materialized message, but the C++ python protobuf backends
+// (cpp and upb) check the actual type of message arguments: there, calls such
+// as other.CopyFrom(message) or other.MergeFrom(message) raise a TypeError,
+// and must be passed message.materialize() instead.
+constexpr bool pybind11_protobuf_enable_lazy_conversion(...) { return false; }
+
+template <typename ProtoType>
+constexpr bool lazy_conversion_enabled() {
+  return pybind11_protobuf_enable_lazy_conversion(
+      static_cast<ProtoType *>(nullptr));
+}
+
+// ADL function to opt into reusing the temporary messages created when loading
+// a ProtoType from python. Defaults to disabled. To enable it, define a
+// constexpr function in the same namespace as the proto, like:
+//
+//  constexpr bool pybind11_protobuf_pool_load_messages(MyProto*)
+//  { return true; }
+//
+// Temporaries are then taken from a small per-thread free list of cleared
+// messages, and returned to it when the call returns, so the capacity of their
+// strings and repeated fields is reused by the next call. By-value, rvalue and
+// std::unique_ptr parameters take ownership of the message, which is then not
+// returned to the list. Pooled messages keep the capacity of the largest
+// message loaded into them. pybind11_protobuf_use_load_arena takes precedence.
+constexpr bool pybind11_protobuf_pool_load_messages(...) { return false; }
+
+template <typename ProtoType>
+constexpr bool pooled_loads_enabled() {
+  return pybind11_protobuf_pool_load_messages(
+      static_cast<ProtoType *>(nullptr));
+}
+
+// The per-thread free list of pybind11_protobuf_pool_load_messages, used as
+// the deleter of pooled messages.
+template <typename ProtoType>
+struct load_message_pool {
+  static constexpr size_t kMaxFreeMessages = 4;
+
+  static ProtoType *acquire() {
+    auto &list = free_list();
+    if (list.empty()) return new ProtoType();
+    ProtoType *message = list.back().release();
+    list.pop_back();
+    return message;
+  }
+
+  void operator()(ProtoType *message) const {
+    auto &list = free_list();
+    if (list.size() >= kMaxFreeMessages) {
+      delete message;
+      return;
+    }
+    message->Clear();
+    list.emplace_back(message);
+  }
+
+ private:
+  static std::vector<std::unique_ptr<ProtoType>> &free_list() {
+    thread_local std::vector<std::unique_ptr<ProtoType>> list;
+    return list;
+  }
+};
+
 // pybind11 constructs c++ references using the following mechanism, for
 // example:
 //
@@ -50,6 +217,16 @@ struct proto_caster_load_impl {
     // NOTE: We might need to know whether the proto has extensions that
     // are python-only.
 
+    // A read-only view refers to a C++ message of this extension module.
+    if (const ::google::protobuf::Message *viewed =
+            pybind11_protobuf::PyProtoViewGetCppMessagePointer(src)) {
+      value = dynamic_cast<const ProtoType *>(viewed);
+      if (value) {
+        pybind11_protobuf::RecordCasterBorrow(*value);
+        return true;
+      }
+    }
+
     // Attempt to use the PyProto_API to get an underlying C++ message pointer
     // from the object.
     const ::google::protobuf::Message *message =
@@ -59,6 +236,7 @@ struct proto_caster_load_impl {
       if (value) {
         // If the capability were available, then we could probe PyProto_API and
         // allow c++ mutability based on the python reference count.
+        pybind11_protobuf::RecordCasterBorrow(*value);
         return true;
       }
     }
@@ -70,16 +248,57 @@ struct proto_caster_load_impl {
                                                 ProtoType::GetDescriptor())) {
       return false;
     }
+    if constexpr (load_arena_enabled<ProtoType>()) {
+      arena.reset(load_arena_pool::acquire());
+      ProtoType *message =
+          ::google::protobuf::Arena::CreateMessage<ProtoType>(&arena->arena);
+      value = message;
+      return pybind11_protobuf::PyProtoCopyToCProto(src, message);
+    }
+    if constexpr (pooled_loads_enabled<ProtoType>()) {
+      pooled.reset(load_message_pool<ProtoType>::acquire());
+      value = pooled.get();
+      return pybind11_protobuf::PyProtoCopyToCProto(src, pooled.get());
+    }
     owned = std::unique_ptr<ProtoType>(new ProtoType());
     value = owned.get();
     return pybind11_protobuf::PyProtoCopyToCProto(src, owned.get());
   }
 
+  // load_into converts from Python -> C++, copying into an existing message.
+  // This is used when the storage is owned elsewhere, such as by a container,
+  // and avoids allocating a temporary message.
+  static bool load_into(pybind11::handle src, ProtoType *dst) {
+    const ::google::protobuf::Message *message =
+        pybind11_protobuf::PyProtoViewGetCppMessagePointer(src);
+    if (!message) {
+      message = pybind11_protobuf::PyProtoGetCppMessagePointer(src);
+    }
+    if (message) {
+      if (auto *typed = dynamic_cast<const ProtoType *>(message)) {
+        pybind11_protobuf::RecordCasterCopy(*typed);
+        *dst = *typed;
+        return true;
+      }
+    }
+    if (!pybind11_protobuf::PyProtoIsCompatible(src,
+                                                ProtoType::GetDescriptor())) {
+      return false;
+    }
+    return pybind11_protobuf::PyProtoCopyToCProto(src, dst);
+  }
+
   // ensure_owned ensures that the owned member contains a copy of the
   // ::google::protobuf::Message.
   void ensure_owned() {
     if (value && !owned) {
+      if (pooled) {
+        // Ownership escapes, so the message does not go back to the pool.
+        owned.reset(pooled.release());
+        return;
+      }
       owned = std::unique_ptr<ProtoType>(value->New());
+      pybind11_protobuf::RecordCasterCopy(*value);
       *owned = *value;
       value = owned.get();
     }
@@ -87,6 +306,11 @@ struct proto_caster_load_impl {
 
   const ProtoType *value;
   std::unique_ptr<ProtoType> owned;
+  // Holds value when it was allocated using pybind11_protobuf_use_load_arena.
+  std::unique_ptr<load_arena_pool::arena_with_block, load_arena_pool> arena;
+  // Holds value when it was taken from the pool of
+  // pybind11_protobuf_pool_load_messages.
+  std::unique_ptr<ProtoType, load_message_pool<ProtoType>> pooled;
 };
 
 template <>
@@ -103,6 +327,7 @@ struct proto_caster_load_impl<::google::protobuf::Message> {
     // from the object.
     value = pybind11_protobuf::PyProtoGetCppMessagePointer(src);
     if (value) {
+      pybind11_protobuf::RecordCasterBorrow(*value);
       return true;
     }
 
@@ -125,6 +350,7 @@ struct proto_caster_load_impl<::google::protobuf::Message> {
   void ensure_owned() {
     if (value && !owned) {
       owned = std::unique_ptr<ProtoType>(value->New());
+      pybind11_protobuf::RecordCasterCopy(*value);
       owned->CopyFrom(*value);
       value = owned.get();
     }
@@ -180,6 +406,23 @@ struct native_cast_impl {
   }
 };
 
+// Converts a container of ProtoType into a python list in a single pass, see
+// GenericProtoListCast(). When move is true the elements of src may be left
+// in a valid but unspecified state.
+template <typename ProtoType, typename Container>
+pybind11::handle cast_proto_list(Container &src, bool move) {
+  std::vector<::google::protobuf::Message *> messages;
+  messages.reserve(src.size());
+  for (auto &value : src) {
+    messages.push_back(const_cast<ProtoType *>(&value));
+  }
+  const ::google::protobuf::Descriptor *descriptor =
+      messages.empty() ? nullptr : messages.front()->GetDescriptor();
+  if (descriptor == nullptr) return pybind11::list().release();
+  return GenericProtoListCast(descriptor, messages.data(), messages.size(),
+                              move);
+}
+
 // pybind11 type_caster specialization for c++ protocol buffer types.
 template <typename ProtoType, typename CastBase>
 struct proto_caster : public proto_caster_load_impl<ProtoType>,
@@ -191,6 +434,25 @@ struct proto_caster : public proto_caster_load_impl<ProtoType>,
   using Loader::owned;
   using Loader::value;
 
+  static bool use_read_only_view(pybind11::return_value_policy policy) {
+    return read_only_views_enabled<ProtoType>() &&
+           (policy == pybind11::return_value_policy::reference ||
+            policy == pybind11::return_value_policy::reference_internal);
+  }
+
+  static pybind11::handle cast_read_only_view(
+      const ProtoType *src, pybind11::return_value_policy policy,
+      pybind11::handle parent) {
+    return pybind11_protobuf::GenericProtoViewCast(
+        src, policy == pybind11::return_value_policy::reference_internal
+                 ? parent
+                 : pybind11::handle());
+  }
+
+  static pybind11::handle cast_lazy(std::shared_ptr<ProtoType> src) {
+    return pybind11_protobuf::GenericProtoLazyCast(std::move(src));
+  }
+
  public:
   static constexpr auto name = pybind11::detail::const_name<ProtoType>();
 
@@ -204,17 +466,29 @@ struct proto_caster : public proto_caster_load_impl<ProtoType>,
   static pybind11::handle cast(ProtoType &&src,
                                pybind11::return_value_policy policy,
                                pybind11::handle parent) {
+    if constexpr (lazy_conversion_enabled<ProtoType>()) {
+      return cast_lazy(std::make_shared<ProtoType>(std::move(src)));
+    }
     return cast_impl(&src, pybind11::return_value_policy::move, parent, false);
   }
 
   static pybind11::handle cast(const ProtoType *src,
                                pybind11::return_value_policy policy,
                                pybind11::handle parent) {
+    if (src && use_read_only_view(policy)) {
+      return cast_read_only_view(src, policy, parent);
+    }
     std::unique_ptr<const ProtoType> wrapper;
     if (policy == pybind11::return_value_policy::automatic ||
         policy == pybind11::return_value_policy::automatic_reference) {
       policy = pybind11::return_value_policy::copy;
     } else if (policy == pybind11::return_value_policy::take_ownership) {
+      if constexpr (lazy_conversion_enabled<ProtoType>()) {
+        if (src) {
+          return cast_lazy(
+              std::shared_ptr<ProtoType>(const_cast<ProtoType *>(src)));
+        }
+      }
       wrapper.reset(src);
     }
     return cast_impl(const_cast<ProtoType *>(src), policy, parent, true);
@@ -229,6 +503,9 @@ struct proto_caster : public proto_caster_load_impl<ProtoType>,
     } else if (policy == pybind11::return_value_policy::automatic ||
                policy == pybind11::return_value_policy::take_ownership) {
       policy = pybind11::return_value_policy::take_ownership;
+      if constexpr (lazy_conversion_enabled<ProtoType>()) {
+        if (src) return cast_lazy(std::shared_ptr<ProtoType>(src));
+      }
       wrapper.reset(src);
     }
     return cast_impl(src, policy, parent, false);
@@ -237,6 +514,9 @@ struct proto_caster : public proto_caster_load_impl<ProtoType>,
   static pybind11::handle cast(ProtoType const &src,
                                pybind11::return_value_policy policy,
                                pybind11::handle parent) {
+    if (use_read_only_view(policy)) {
+      return cast_read_only_view(&src, policy, parent);
+    }
     if (policy == pybind11::return_value_policy::automatic ||
         policy == pybind11::return_value_policy::automatic_reference) {
       policy = pybind11::return_value_policy::copy;
@@ -7,16 +7,25 @@
 
 #include <pybind11/functional.h>
 
+#include <algorithm>
+#include <atomic>
 #include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <stdexcept>
 #include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 #include "google/protobuf/descriptor.pb.h"
 #include "google/protobuf/descriptor.h"
 #include "google/protobuf/message.h"
 #include "google/protobuf/reflection.h"
+#include "google/protobuf/repeated_field.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
 
 namespace pybind11 {
 namespace google {
@@ -271,6 +280,10 @@ class ProtoFieldContainer {};
     std::string ElementRepr(int idx) const {                             \
       return std::to_string(Get(idx));                                   \
     }                                                                    \
+    ::google::protobuf::RepeatedField<cpp_type>* MutableRepeatedField() { \
+      return reflection_->MutableRepeatedField<cpp_type>(proto_,         \
+                                                         field_desc_);   \
+    }                                                                    \
   }
 
 NUMERIC_FIELD_REFLECTION_SPECIALIZATION(Int32, int32_t);
@@ -390,7 +403,75 @@ class ProtoFieldContainer<::google::protobuf::Message> : public ProtoFieldContai
   }
 };
 
-// Specialization for enums.
+// The numbers of the values of an enum, held as a bitmap over [min, max] when
+// that range is dense, to validate numbers without EnumValueDescriptor
+// lookups. Sparse enums fall back to FindValueByNumber().
+class EnumValidityTable {
+ public:
+  explicit EnumValidityTable(const ::google::protobuf::EnumDescriptor* enum_desc)
+      : enum_desc_(enum_desc) {
+    min_ = max_ = enum_desc->value(0)->number();
+    for (int i = 1; i < enum_desc->value_count(); ++i) {
+      min_ = std::min(min_, enum_desc->value(i)->number());
+      max_ = std::max(max_, enum_desc->value(i)->number());
+    }
+    int64_t range = static_cast<int64_t>(max_) - min_ + 1;
+    if (range <= kMaxDenseRange) {
+      valid_.resize(range);
+      for (int i = 0; i < enum_desc->value_count(); ++i) {
+        valid_[enum_desc->value(i)->number() - min_] = true;
+      }
+    }
+  }
+
+  bool IsValid(int number) const {
+    if (number < min_ || number > max_) return false;
+    if (!valid_.empty()) return valid_[static_cast<int64_t>(number) - min_];
+    return enum_desc_->FindValueByNumber(number) != nullptr;
+  }
+
+ private:
+  static constexpr int64_t kMaxDenseRange = 1 << 16;
+
+  const ::google::protobuf::EnumDescriptor* enum_desc_;
+  int min_;
+  int max_;
+  std::vector<bool> valid_;
+};
+
+// Returns the validity table of an enum, or nullptr for enums outside the
+// generated pool, whose descriptors may be deleted. The tables are built on
+// first use and never freed, and are published in lock-free snapshots as in
+// GetFieldAccessors().
+const EnumValidityTable* GetEnumValidityTable(
+    const ::google::protobuf::EnumDescriptor* enum_desc) {
+  if (enum_desc->file()->pool() != ::google::protobuf::DescriptorPool::generated_pool()) {
+    return nullptr;
+  }
+  using TableMap = absl::flat_hash_map<const ::google::protobuf::EnumDescriptor*,
+                                       const EnumValidityTable*>;
+  static std::atomic<const TableMap*> snapshot{new TableMap()};
+  static absl::Mutex mutex;
+
+  const TableMap* current = snapshot.load(std::memory_order_acquire);
+  if (auto it = current->find(enum_desc); it != current->end()) {
+    return it->second;
+  }
+
+  absl::MutexLock lock(&mutex);
+  current = snapshot.load(std::memory_order_acquire);
+  if (auto it = current->find(enum_desc); it != current->end()) {
+    return it->second;
+  }
+  auto* table = new EnumValidityTable(enum_desc);
+  auto* updated = new TableMap(*current);
+  updated->emplace(enum_desc, table);
+  snapshot.store(updated, std::memory_order_release);
+  return table;
+}
+
+// Specialization for enums. Values are read and written as numbers; the
+// EnumValueDescriptor is only looked up for repr.
 template <>
 class ProtoFieldContainer<GenericEnum> : public ProtoFieldContainerBase {
  public:
@@ -403,7 +484,14 @@ class ProtoFieldContainer<GenericEnum> : public ProtoFieldContainerBase {
       return reflection_->GetEnum(*proto_, field_desc_);
     }
   }
-  int Get(int idx) const { return GetDesc(idx)->number(); }
+  int Get(int idx) const {
+    if (field_desc_->is_repeated()) {
+      return reflection_->GetRepeatedEnumValue(*proto_, field_desc_,
+                                               CheckIndex(idx));
+    } else {
+      return reflection_->GetEnumValue(*proto_, field_desc_);
+    }
+  }
   object GetPython(int idx) const { return cast(Get(idx)); }
   void Set(int idx, int value) {
     if (field_desc_->is_repeated()) {
@@ -419,7 +507,31 @@ class ProtoFieldContainer<GenericEnum> : public ProtoFieldContainerBase {
   void Append(handle value) {
     reflection_->AddEnumValue(proto_, field_desc_, CastOrTypeError<int>(value));
   }
+  // Appends numbers in bulk. Numbers which are not values of a closed enum
+  // go through AddEnumValue(), which keeps them as unknown fields.
+  void AddValues(const int32_t* begin, const int32_t* end) {
+    auto* field = MutableRepeatedField();
+    const ::google::protobuf::EnumDescriptor* enum_desc = field_desc_->enum_type();
+    if (!enum_desc->is_closed()) {
+      field->Add(begin, end);
+      return;
+    }
+    const EnumValidityTable* table = GetEnumValidityTable(enum_desc);
+    field->Reserve(field->size() + static_cast<int>(end - begin));
+    for (const int32_t* it = begin; it != end; ++it) {
+      if (table ? table->IsValid(*it)
+                : enum_desc->FindValueByNumber(*it) != nullptr) {
+        field->Add(*it);
+      } else {
+        reflection_->AddEnumValue(proto_, field_desc_, *it);
+      }
+    }
+  }
   std::string ElementRepr(int idx) const { return GetDesc(idx)->name(); }
+  // Enum fields are stored as a RepeatedField<int32_t>.
+  ::google::protobuf::RepeatedField<int32_t>* MutableRepeatedField() {
+    return reflection_->MutableRepeatedField<int32_t>(proto_, field_desc_);
+  }
 };
 
 // A container for a repeated field.
@@ -431,6 +543,41 @@ class RepeatedFieldContainer : public ProtoFieldContainer<T> {
     return this->CastAndKeepAlive(this, return_value_policy::copy);
   }
   void Extend(handle src) {
+    if constexpr (std::is_arithmetic<T>::value) {
+      // Numpy arrays, array.array etc. of the element type are copied in bulk.
+      if (PyObject_CheckBuffer(src.ptr())) {
+        auto values = reinterpret_borrow<buffer>(src);
+        buffer_info info = values.request();
+        if (IsCompatibleBuffer(info)) {
+          AddFromBuffer(info);
+          return;
+        }
+      }
+    }
+    if constexpr (std::is_same<T, GenericEnum>::value) {
+      // Numbers are converted first, then added in bulk; int32 buffers, such
+      // as numpy arrays of labels, are added without conversion.
+      if (PyObject_CheckBuffer(src.ptr())) {
+        buffer_info info = reinterpret_borrow<buffer>(src).request();
+        if (info.ndim == 1 &&
+            info.strides[0] == static_cast<ssize_t>(sizeof(int32_t)) &&
+            info.item_type_is_equivalent_to<int32_t>()) {
+          const auto* begin = static_cast<const int32_t*>(info.ptr);
+          this->AddValues(begin, begin + info.size);
+          return;
+        }
+      }
+      if (isinstance<sequence>(src)) {
+        auto values = reinterpret_borrow<sequence>(src);
+        std::vector<int32_t> numbers;
+        numbers.reserve(values.size());
+        for (auto value : values) {
+          numbers.push_back(CastOrTypeError<int>(value));
+        }
+        this->AddValues(numbers.data(), numbers.data() + numbers.size());
+        return;
+      }
+    }
     if (!isinstance<sequence>(src))
       throw std::invalid_argument("Extend: Passed value is not a sequence.");
     auto values = reinterpret_borrow<sequence>(src);
@@ -498,35 +645,32 @@ class RepeatedFieldContainer : public ProtoFieldContainer<T> {
   }
 
  protected:
+  // Whether Extend() may copy a buffer of numeric or bool elements in bulk.
+  static bool IsCompatibleBuffer(const buffer_info& info) {
+    return info.ndim == 1 &&
+           info.strides[0] == static_cast<ssize_t>(sizeof(T)) &&
+           info.item_type_is_equivalent_to<T>();
+  }
+  void AddFromBuffer(const buffer_info& info) {
+    const T* begin = static_cast<const T*>(info.ptr);
+    this->MutableRepeatedField()->Add(begin, begin + info.size);
+  }
+
   void SwapElements(int i1, int i2) {
     this->reflection_->SwapElements(this->proto_, this->field_desc_, i1, i2);
   }
 };
 
-// Struct which can be used with DispatchFieldDescriptor to find (or add)
-// the map pair (key, value) message with the given key.
+// Struct which can be used with DispatchFieldDescriptor to add a map pair
+// (key, value) message with the given key, and a default value.
 template <typename KeyT>
-struct FindMapPair {
+struct AddMapPair {
   static ::google::protobuf::Message* HandleField(const ::google::protobuf::FieldDescriptor* key_desc,
                                       ::google::protobuf::Message* proto,
                                       const ::google::protobuf::FieldDescriptor* map_desc,
-                                      handle key, bool add_key = true) {
-    // When using the proto reflection API, maps are represented as repeated
-    // message fields (messages with 2 elements: 'key' and 'value'). If protocol
-    // buffers guarrantee a consistent (and useful) ordering of elements,
-    // it should be possible to do this search in O(log(n)) time. However, that
-    // requires more knowledge of protobuf internals than I have, so for now
-    // assume a random ordering of elements, in which case a O(n) search is
-    // the best you can do.
-    RepeatedFieldContainer<::google::protobuf::Message> map_field(proto, map_desc);
-    for (int i = 0; i < map_field.Size(); ++i) {
-      ::google::protobuf::Message* kv_pair = map_field.Get(i);
-      if (ProtoFieldContainer<KeyT>(kv_pair, key_desc).GetPython(-1).equal(key))
-        return kv_pair;
-    }
-    // Key not found
-    if (!add_key) return nullptr;
-    ::google::protobuf::Message* new_kv_pair = map_field.Add();
+                                      handle key) {
+    ::google::protobuf::Message* new_kv_pair =
+        RepeatedFieldContainer<::google::protobuf::Message>(proto, map_desc).Add();
     ProtoFieldContainer<KeyT>(new_kv_pair, key_desc).SetPython(-1, key);
     return new_kv_pair;
   }
@@ -575,7 +719,26 @@ class MapFieldContainer : public RepeatedFieldContainer<::google::protobuf::Mess
     GetValueContainer(key).SetPython(-1, value);
   }
   void UpdateFromDict(dict values) {
-    for (auto& item : values) SetItem(item.first, item.second);
+    // Index the pairs by key for the duration of the update, so that setting
+    // n items costs O(n) rather than a scan of the pairs per item. The index
+    // is not kept between calls, since the pairs may meanwhile be edited
+    // elsewhere, such as by another container or through reflection.
+    dict index;
+    for (int i = 0; i < Size(); ++i) index[GetKey(Get(i))] = int_(i);
+    for (auto& item : values) {
+      ::google::protobuf::Message* kv_pair;
+      PyObject* cached = PyDict_GetItemWithError(index.ptr(), item.first.ptr());
+      if (cached != nullptr) {
+        kv_pair = Get(PyLong_AsLong(cached));
+      } else {
+        if (PyErr_Occurred()) throw error_already_set();
+        kv_pair = DispatchFieldDescriptor<AddMapPair>(key_desc_, proto_,
+                                                      field_desc_, item.first);
+        index[item.first] = int_(Size() - 1);
+      }
+      ProtoFieldContainer<MappedType>(kv_pair, value_desc_, proto_)
+          .SetPython(-1, item.second);
+    }
   }
   void UpdateFromKWArgs(kwargs values) { UpdateFromDict(values); }
   void UpdateFromHandle(handle values) {
@@ -583,10 +746,7 @@ class MapFieldContainer : public RepeatedFieldContainer<::google::protobuf::Mess
       throw std::invalid_argument("Update: Passed value is not a dictionary.");
     UpdateFromDict(reinterpret_borrow<dict>(values));
   }
-  bool Contains(handle key) const {
-    return DispatchFieldDescriptor<FindMapPair>(key_desc_, proto_, field_desc_,
-                                                key, false) != nullptr;
-  }
+  bool Contains(handle key) const { return FindPair(key, false) != nullptr; }
   std::string Repr() const {
     if (Size() == 0) return "{}";
     std::string repr = "{";
@@ -645,11 +805,28 @@ class MapFieldContainer : public RepeatedFieldContainer<::google::protobuf::Mess
 
   // Get the ProtoFieldContainer for the value corresponding to the given key.
   ProtoFieldContainer<MappedType> GetValueContainer(handle key) const {
-    ::google::protobuf::Message* kv_pair = DispatchFieldDescriptor<FindMapPair>(
-        key_desc_, proto_, field_desc_, key);
+    ::google::protobuf::Message* kv_pair = FindPair(key, true);
     return ProtoFieldContainer<MappedType>(kv_pair, value_desc_, proto_);
   }
 
+  // Returns the key-value pair message with the given key, adding it when
+  // missing if add_key is set. Through reflection a map is a repeated field
+  // of key-value pairs, in no particular order, so this scans the pairs; the
+  // hash index of the underlying Map is not exposed (Reflection::
+  // LookupMapValue is private).
+  ::google::protobuf::Message* FindPair(handle key, bool add_key) const {
+    for (int i = 0; i < Size(); ++i) {
+      ::google::protobuf::Message* kv_pair = Get(i);
+      if (DispatchFieldDescriptor<GetMapKey>(key_desc_, kv_pair, proto_)
+              .equal(key)) {
+        return kv_pair;
+      }
+    }
+    if (!add_key) return nullptr;
+    return DispatchFieldDescriptor<AddMapPair>(key_desc_, proto_, field_desc_,
+                                               key);
+  }
+
   // Get the key out of the given key-value message.
   object GetKey(::google::protobuf::Message* kv_pair) {
     return DispatchFieldDescriptor<GetMapKey>(key_desc_, kv_pair, proto_);
@@ -670,20 +847,24 @@ class MapFieldContainer : public RepeatedFieldContainer<::google::protobuf::Mess
   const ::google::protobuf::FieldDescriptor* value_desc_;
 };
 
+[[noreturn]] void ThrowNoSuchField(::google::protobuf::Message* message,
+                                   absl::string_view name,
+                                   PyObject* error_type) {
+  std::string error_str =
+      "'" + message->GetTypeName() + "' object has no attribute '";
+  error_str.append(std::string(name));
+  error_str.append("'");
+  PyErr_SetString(error_type, error_str.c_str());
+  throw error_already_set();
+}
+
 const ::google::protobuf::FieldDescriptor* GetFieldDescriptor(
     ::google::protobuf::Message* message, absl::string_view name,
     PyObject* error_type = PyExc_AttributeError) {
   auto* field_desc =
   message->GetDescriptor()->FindFieldByName(std::string(name));
 
-  if (!field_desc) {
-    std::string error_str =
-        "'" + message->GetTypeName() + "' object has no attribute '";
-    error_str.append(std::string(name));
-    error_str.append("'");
-    PyErr_SetString(error_type, error_str.c_str());
-    throw error_already_set();
-  }
+  if (!field_desc) ThrowNoSuchField(message, name, error_type);
   return field_desc;
 }
 
@@ -723,6 +904,87 @@ struct TemplatedProtoSetField {
   }
 };
 
+// A field together with the get and set functions which
+// DispatchFieldDescriptor selects for its type.
+struct FieldAccessor {
+  const ::google::protobuf::FieldDescriptor* field_desc;
+  object (*get)(const ::google::protobuf::FieldDescriptor*, ::google::protobuf::Message*);
+  void (*set)(const ::google::protobuf::FieldDescriptor*, ::google::protobuf::Message*, handle);
+};
+
+// Struct used with DispatchFieldDescriptor to build a FieldAccessor.
+template <typename ValueType>
+struct MakeFieldAccessor {
+  static FieldAccessor HandleField(const ::google::protobuf::FieldDescriptor* field_desc) {
+    return {field_desc, &TemplatedProtoGetField<ValueType>::HandleField,
+            &TemplatedProtoSetField<ValueType>::HandleField};
+  }
+};
+
+using FieldAccessorMap = absl::flat_hash_map<std::string, FieldAccessor>;
+
+// Returns the accessors of the fields of a message type, by name, or nullptr
+// for types outside the generated pool, whose descriptors may be deleted.
+// The tables are built on first use and never freed, so the returned table
+// stays valid. Callers may not hold a GIL in free-threaded builds, so the
+// common path is a lock-free lookup into an immutable snapshot, as in
+// GetSearchPlan() (check_unknown_fields.cc). A miss builds the table, which
+// does not call into python, and publishes a new snapshot under a mutex.
+// Replaced snapshots are leaked, as concurrent readers may still be using
+// them; there is at most one per message type.
+const FieldAccessorMap* GetFieldAccessors(const ::google::protobuf::Descriptor* descriptor) {
+  if (descriptor->file()->pool() != ::google::protobuf::DescriptorPool::generated_pool()) {
+    return nullptr;
+  }
+  using TableMap =
+      absl::flat_hash_map<const ::google::protobuf::Descriptor*, const FieldAccessorMap*>;
+  static std::atomic<const TableMap*> snapshot{new TableMap()};
+  static absl::Mutex mutex;
+
+  const TableMap* current = snapshot.load(std::memory_order_acquire);
+  if (auto it = current->find(descriptor); it != current->end()) {
+    return it->second;
+  }
+
+  absl::MutexLock lock(&mutex);
+  current = snapshot.load(std::memory_order_acquire);
+  if (auto it = current->find(descriptor); it != current->end()) {
+    return it->second;
+  }
+  auto* table = new FieldAccessorMap();
+  for (int i = 0; i < descriptor->field_count(); ++i) {
+    const ::google::protobuf::FieldDescriptor* field_desc = descriptor->field(i);
+    table->emplace(field_desc->name(),
+                   DispatchFieldDescriptor<MakeFieldAccessor>(field_desc));
+  }
+  auto* updated = new TableMap(*current);
+  updated->emplace(descriptor, table);
+  snapshot.store(updated, std::memory_order_release);
+  return table;
+}
+
+// Returns the accessor for the field with the given name, looking it up in
+// `accessors` when set.
+FieldAccessor GetFieldAccessor(const FieldAccessorMap* accessors,
+                               ::google::protobuf::Message* message,
+                               absl::string_view name) {
+  if (accessors == nullptr) {
+    return DispatchFieldDescriptor<MakeFieldAccessor>(
+        GetFieldDescriptor(message, name));
+  }
+  auto it = accessors->find(name);
+  if (it == accessors->end()) {
+    ThrowNoSuchField(message, name, PyExc_AttributeError);
+  }
+  return it->second;
+}
+
+FieldAccessor GetFieldAccessor(::google::protobuf::Message* message,
+                               absl::string_view name) {
+  return GetFieldAccessor(GetFieldAccessors(message->GetDescriptor()),
+                          message, name);
+}
+
 }  // namespace
 
 bool PyProtoFullName(handle py_proto, std::string* name) {
@@ -807,7 +1069,8 @@ std::unique_ptr<::google::protobuf::Message> PyProtoAllocateMessage(
 }
 
 object ProtoGetField(::google::protobuf::Message* message, absl::string_view name) {
-  return ProtoGetField(message, GetFieldDescriptor(message, name));
+  FieldAccessor accessor = GetFieldAccessor(message, name);
+  return accessor.get(accessor.field_desc, message);
 }
 
 object ProtoGetField(::google::protobuf::Message* message,
@@ -815,13 +1078,9 @@ object ProtoGetField(::google::protobuf::Message* message,
   return DispatchFieldDescriptor<TemplatedProtoGetField>(field_desc, message);
 }
 
-void ProtoSetField(::google::protobuf::Message* message, absl::string_view name,
-                   handle value) {
-  ProtoSetField(message, GetFieldDescriptor(message, name), value);
-}
+namespace {
 
-void ProtoSetField(::google::protobuf::Message* message,
-                   const ::google::protobuf::FieldDescriptor* field_desc, handle value) {
+void CheckFieldAssignable(const ::google::protobuf::FieldDescriptor* field_desc) {
   if (field_desc->is_map() || field_desc->is_repeated() ||
       field_desc->type() == ::google::protobuf::FieldDescriptor::TYPE_MESSAGE) {
     std::string error = "Assignment not allowed to field \"" +
@@ -829,6 +1088,20 @@ void ProtoSetField(::google::protobuf::Message* message,
     PyErr_SetString(PyExc_AttributeError, error.c_str());
     throw error_already_set();
   }
+}
+
+}  // namespace
+
+void ProtoSetField(::google::protobuf::Message* message, absl::string_view name,
+                   handle value) {
+  FieldAccessor accessor = GetFieldAccessor(message, name);
+  CheckFieldAssignable(accessor.field_desc);
+  accessor.set(accessor.field_desc, message, value);
+}
+
+void ProtoSetField(::google::protobuf::Message* message,
+                   const ::google::protobuf::FieldDescriptor* field_desc, handle value) {
+  CheckFieldAssignable(field_desc);
   DispatchFieldDescriptor<TemplatedProtoSetField>(field_desc, message, value);
 }
 
@@ -837,10 +1110,12 @@ void ProtoInitFields(::google::protobuf::Message* message, kwargs kwargs_in) {
   // be wrapped by loader_life_support.
   pybind11::detail::loader_life_support life_support;
 
+  const FieldAccessorMap* accessors =
+      GetFieldAccessors(message->GetDescriptor());
   for (auto& item : kwargs_in) {
-    DispatchFieldDescriptor<TemplatedProtoSetField>(
-        GetFieldDescriptor(message, cast<absl::string_view>(item.first)),
-        message, item.second);
+    FieldAccessor accessor = GetFieldAccessor(
+        accessors, message, cast<absl::string_view>(item.first));
+    accessor.set(accessor.field_desc, message, item.second);
   }
 }
 
@@ -0,0 +1,580 @@
+#include "pybind11_protobuf/proto_view.h"
+
+#include <Python.h>
+#include <pybind11/cast.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/pytypes.h>
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/message.h"
+#include "pybind11_protobuf/proto_cast_util.h"
+
+namespace py = pybind11;
+
+namespace pybind11_protobuf {
+namespace {
+
+using ::google::protobuf::Descriptor;
+using ::google::protobuf::FieldDescriptor;
+using ::google::protobuf::Message;
+using ::google::protobuf::OneofDescriptor;
+using ::google::protobuf::Reflection;
+
+// The C++ object held by a python read-only view.
+class ReadOnlyProtoView {
+ public:
+  ReadOnlyProtoView(const Message* message,
+                    std::shared_ptr<const Message> owner)
+      : message_(message), owner_(std::move(owner)) {}
+
+  const Message& message() const { return *message_; }
+  const std::shared_ptr<const Message>& owner() const { return owner_; }
+
+ private:
+  const Message* message_;
+  std::shared_ptr<const Message> owner_;
+};
+
+// The python type of ReadOnlyProtoView, once registered.
+std::atomic<PyTypeObject*> view_type{nullptr};
+
+// Returns a view of a submessage of `self`. The submessage view shares the
+// owner of `self` when there is one, otherwise it keeps `self` alive.
+py::object SubmessageView(py::handle py_self, const ReadOnlyProtoView& self,
+                          const Message& submessage) {
+  if (self.owner()) {
+    return py::reinterpret_steal<py::object>(GenericProtoViewCast(
+        &submessage, py::handle(),
+        std::shared_ptr<const Message>(self.owner(), &submessage)));
+  }
+  return py::reinterpret_steal<py::object>(
+      GenericProtoViewCast(&submessage, py_self));
+}
+
+// Converts the value of a field to python. `index` selects an element of a
+// repeated field, and is ignored for singular fields.
+py::object GetFieldValue(py::handle py_self, const ReadOnlyProtoView& self,
+                         const FieldDescriptor* field, int index) {
+  const Message& message = self.message();
+  const Reflection& reflection = *message.GetReflection();
+  const bool repeated = field->is_repeated();
+  switch (field->cpp_type()) {
+    case FieldDescriptor::CPPTYPE_INT32:
+      return py::int_(repeated ? reflection.GetRepeatedInt32(message, field,
+                                                             index)
+                               : reflection.GetInt32(message, field));
+    case FieldDescriptor::CPPTYPE_INT64:
+      return py::int_(repeated ? reflection.GetRepeatedInt64(message, field,
+                                                             index)
+                               : reflection.GetInt64(message, field));
+    case FieldDescriptor::CPPTYPE_UINT32:
+      return py::int_(repeated ? reflection.GetRepeatedUInt32(message, field,
+                                                              index)
+                               : reflection.GetUInt32(message, field));
+    case FieldDescriptor::CPPTYPE_UINT64:
+      return py::int_(repeated ? reflection.GetRepeatedUInt64(message, field,
+                                                              index)
+                               : reflection.GetUInt64(message, field));
+    case FieldDescriptor::CPPTYPE_DOUBLE:
+      return py::float_(repeated ? reflection.GetRepeatedDouble(message, field,
+                                                                index)
+                                 : reflection.GetDouble(message, field));
+    case FieldDescriptor::CPPTYPE_FLOAT:
+      return py::float_(repeated ? reflection.GetRepeatedFloat(message, field,
+                                                               index)
+                                 : reflection.GetFloat(message, field));
+    case FieldDescriptor::CPPTYPE_BOOL:
+      return py::bool_(repeated ? reflection.GetRepeatedBool(message, field,
+                                                             index)
+                                : reflection.GetBool(message, field));
+    case FieldDescriptor::CPPTYPE_ENUM:
+      return py::int_(repeated ? reflection.GetRepeatedEnumValue(message, field,
+                                                                 index)
+                               : reflection.GetEnumValue(message, field));
+    case FieldDescriptor::CPPTYPE_STRING: {
+      std::string scratch;
+      const std::string& value =
+          repeated ? reflection.GetRepeatedStringReference(message, field,
+                                                           index, &scratch)
+                   : reflection.GetStringReference(message, field, &scratch);
+      if (field->type() == FieldDescriptor::TYPE_BYTES) {
+        return py::bytes(value);
+      }
+      return py::str(value);
+    }
+    case FieldDescriptor::CPPTYPE_MESSAGE:
+      return SubmessageView(
+          py_self, self,
+          repeated ? reflection.GetRepeatedMessage(message, field, index)
+                   : reflection.GetMessage(message, field));
+  }
+  throw py::type_error("Unsupported field type for " + field->full_name());
+}
+
+// Returns a field as python would: repeated fields become tuples, maps become
+// dicts and submessages become read-only views.
+py::object GetField(py::handle py_self, const std::string& name) {
+  const auto& self = py_self.cast<const ReadOnlyProtoView&>();
+  const Message& message = self.message();
+  const FieldDescriptor* field =
+      message.GetDescriptor()->FindFieldByName(name);
+  if (field == nullptr) {
+    throw py::attribute_error(message.GetDescriptor()->full_name() +
+                              " has no field " + name);
+  }
+  if (!field->is_repeated()) {
+    return GetFieldValue(py_self, self, field, 0);
+  }
+
+  int size = message.GetReflection()->FieldSize(message, field);
+  if (field->is_map()) {
+    const FieldDescriptor* key = field->message_type()->map_key();
+    const FieldDescriptor* value = field->message_type()->map_value();
+    py::dict result;
+    for (int i = 0; i < size; ++i) {
+      py::object entry = GetFieldValue(py_self, self, field, i);
+      const auto& entry_view = entry.cast<const ReadOnlyProtoView&>();
+      result[GetFieldValue(entry, entry_view, key, 0)] =
+          GetFieldValue(entry, entry_view, value, 0);
+    }
+    return std::move(result);
+  }
+  py::tuple result(size);
+  for (int i = 0; i < size; ++i) {
+    result[i] = GetFieldValue(py_self, self, field, i);
+  }
+  return std::move(result);
+}
+
+// The elements of a repeated numeric field of a view, which python reads in
+// place through the buffer protocol. Holds the view, which keeps the message
+// alive.
+struct RepeatedFieldBuffer {
+  py::object view;
+  const void* data;
+  py::ssize_t itemsize;
+  std::string format;
+  py::ssize_t size;
+};
+
+template <typename T>
+RepeatedFieldBuffer MakeRepeatedFieldBuffer(py::handle py_self,
+                                            const Message& message,
+                                            const FieldDescriptor* field) {
+  static const T empty = T();
+  const auto& values =
+      message.GetReflection()->GetRepeatedField<T>(message, field);
+  return {py::reinterpret_borrow<py::object>(py_self),
+          values.empty() ? &empty : values.data(),
+          static_cast<py::ssize_t>(sizeof(T)),
+          py::format_descriptor<T>::format(), values.size()};
+}
+
+// Returns a read-only memoryview over the elements of a repeated numeric,
+// bool or enum field, without copying them. Like the view, it reads the C++
+// message in place, and must not be used after C++ code resizes the field.
+py::memoryview FieldBuffer(py::handle py_self, const std::string& name) {
+  const Message& message = py_self.cast<const ReadOnlyProtoView&>().message();
+  const FieldDescriptor* field =
+      message.GetDescriptor()->FindFieldByName(name);
+  if (field == nullptr) {
+    throw py::attribute_error(message.GetDescriptor()->full_name() +
+                              " has no field " + name);
+  }
+  if (!field->is_repeated()) {
+    throw py::type_error(field->full_name() + " is not a repeated field");
+  }
+  RepeatedFieldBuffer buffer;
+  switch (field->cpp_type()) {
+    case FieldDescriptor::CPPTYPE_INT32:
+    case FieldDescriptor::CPPTYPE_ENUM:
+      buffer = MakeRepeatedFieldBuffer<int32_t>(py_self, message, field);
+      break;
+    case FieldDescriptor::CPPTYPE_INT64:
+      buffer = MakeRepeatedFieldBuffer<int64_t>(py_self, message, field);
+      break;
+    case FieldDescriptor::CPPTYPE_UINT32:
+      buffer = MakeRepeatedFieldBuffer<uint32_t>(py_self, message, field);
+      break;
+    case FieldDescriptor::CPPTYPE_UINT64:
+      buffer = MakeRepeatedFieldBuffer<uint64_t>(py_self, message, field);
+      break;
+    case FieldDescriptor::CPPTYPE_DOUBLE:
+      buffer = MakeRepeatedFieldBuffer<double>(py_self, message, field);
+      break;
+    case FieldDescriptor::CPPTYPE_FLOAT:
+      buffer = MakeRepeatedFieldBuffer<float>(py_self, message, field);
+      break;
+    case FieldDescriptor::CPPTYPE_BOOL:
+      buffer = MakeRepeatedFieldBuffer<bool>(py_self, message, field);
+      break;
+    default:
+      throw py::type_error(field->full_name() +
+                           " is not a repeated numeric field");
+  }
+  return py::memoryview(
+      py::cast(std::move(buffer), py::return_value_policy::move));
+}
+
+bool HasField(const ReadOnlyProtoView& self, const std::string& name) {
+  const Message& message = self.message();
+  const Descriptor* descriptor = message.GetDescriptor();
+  if (const OneofDescriptor* oneof = descriptor->FindOneofByName(name)) {
+    return message.GetReflection()->HasOneof(message, oneof);
+  }
+  const FieldDescriptor* field = descriptor->FindFieldByName(name);
+  if (field == nullptr || !field->has_presence()) {
+    throw py::value_error("Protocol message " + descriptor->full_name() +
+                          " has no singular \"" + name + "\" field.");
+  }
+  return message.GetReflection()->HasField(message, field);
+}
+
+py::object WhichOneof(const ReadOnlyProtoView& self, const std::string& name) {
+  const Message& message = self.message();
+  const OneofDescriptor* oneof =
+      message.GetDescriptor()->FindOneofByName(name);
+  if (oneof == nullptr) {
+    throw py::value_error("Protocol message has no oneof \"" + name +
+                          "\" field.");
+  }
+  const FieldDescriptor* field =
+      message.GetReflection()->GetOneofFieldDescriptor(message, oneof);
+  if (field == nullptr) return py::none();
+  return py::str(field->name());
+}
+
+// Returns the python descriptor of a C++ message, from the default pool.
+py::object PyDescriptorOf(const Message& message) {
+  try {
+    return py::module_::import("google.protobuf.descriptor_pool")
+        .attr("Default")()
+        .attr("FindMessageTypeByName")(message.GetDescriptor()->full_name());
+  } catch (py::error_already_set& e) {
+    throw py::attribute_error(e.what());
+  }
+}
+
+// The C++ object held by a python lazy message. Until it is materialized, a
+// lazy message reads fields from a C++ message which it owns; afterwards it
+// forwards everything to the materialized python message.
+//
+// Submessages of a lazy message are lazy messages reading from the same C++
+// message. They refer to their root by a path of fields, so that once the
+// root is materialized they forward to the matching python submessage.
+class LazyProtoMessage {
+ public:
+  explicit LazyProtoMessage(std::shared_ptr<Message> message)
+      : message_(message.get()), owner_(std::move(message)) {}
+
+  LazyProtoMessage(py::object root, std::vector<const FieldDescriptor*> path,
+                   const Message* message, std::shared_ptr<const Message> owner)
+      : root_(std::move(root)),
+        path_(std::move(path)),
+        message_(message),
+        owner_(std::move(owner)) {}
+
+  // Returns the C++ message, or nullptr once materialized.
+  const Message* message() const {
+    return is_materialized() ? nullptr : message_;
+  }
+
+  bool is_materialized() const {
+    if (root_) return root_.cast<const LazyProtoMessage&>().is_materialized();
+    return static_cast<bool>(materialized_);
+  }
+
+  // Returns the python message, converting the C++ message on first use.
+  py::object Materialize() {
+    if (root_) {
+      py::object result = root_.cast<LazyProtoMessage&>().Materialize();
+      for (const FieldDescriptor* field : path_) {
+        result = result.attr(field->name().c_str());
+      }
+      return result;
+    }
+    if (!materialized_) {
+      // The root owns its message, so the contents may be moved.
+      materialized_ = py::reinterpret_steal<py::object>(
+          GenericProtoCast(const_cast<Message*>(message_),
+                           py::return_value_policy::move, py::handle(),
+                           false));
+      owner_.reset();
+    }
+    return materialized_;
+  }
+
+  // Returns a lazy message for a singular submessage field.
+  py::object Submessage(py::handle py_self, const FieldDescriptor* field) {
+    const Message& submessage =
+        message_->GetReflection()->GetMessage(*message_, field);
+    std::vector<const FieldDescriptor*> path = path_;
+    path.push_back(field);
+    return py::cast(
+        LazyProtoMessage(root_ ? root_ : py::reinterpret_borrow<py::object>(
+                                              py_self),
+                         std::move(path), &submessage,
+                         std::shared_ptr<const Message>(owner_, &submessage)),
+        py::return_value_policy::move);
+  }
+
+ private:
+  py::object root_;
+  std::vector<const FieldDescriptor*> path_;
+  const Message* message_;
+  std::shared_ptr<const Message> owner_;
+  py::object materialized_;
+};
+
+// The python type of LazyProtoMessage, once registered.
+std::atomic<PyTypeObject*> lazy_type{nullptr};
+
+// Reads singular fields from the C++ message while there is one; repeated
+// fields, maps and everything else come from the materialized message.
+py::object GetLazyAttr(py::handle py_self, const std::string& name) {
+  auto& self = py_self.cast<LazyProtoMessage&>();
+  if (const Message* message = self.message()) {
+    const FieldDescriptor* field =
+        message->GetDescriptor()->FindFieldByName(name);
+    if (field != nullptr && !field->is_repeated()) {
+      if (field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE) {
+        return self.Submessage(py_self, field);
+      }
+      return GetFieldValue(py_self, ReadOnlyProtoView(message, nullptr), field,
+                           0);
+    }
+  }
+  return self.Materialize().attr(name.c_str());
+}
+
+void RegisterLazyType(py::module_ scope) {
+  py::class_<LazyProtoMessage> cls(scope, "LazyMessage", py::module_local());
+  cls.def("__getattr__", &GetLazyAttr)
+      .def("__setattr__",
+           [](LazyProtoMessage& self, const std::string& name,
+              py::handle value) {
+             py::setattr(self.Materialize(), name.c_str(), value);
+           })
+      .def("__repr__",
+           [](LazyProtoMessage& self) -> py::object {
+             const Message* message = self.message();
+             if (message == nullptr) return py::repr(self.Materialize());
+             return py::str("<lazy " + message->GetDescriptor()->full_name() +
+                            ": " + message->ShortDebugString() + ">");
+           })
+      .def("__eq__",
+           [](LazyProtoMessage& self, py::handle other) {
+             return self.Materialize().equal(other);
+           })
+      .def("__reduce_ex__",
+           [](LazyProtoMessage& self, py::handle protocol) {
+             return self.Materialize().attr("__reduce_ex__")(protocol);
+           })
+      .def("HasField",
+           [](LazyProtoMessage& self, const std::string& name) -> py::object {
+             const Message* message = self.message();
+             if (message == nullptr) {
+               return self.Materialize().attr("HasField")(name);
+             }
+             return py::bool_(HasField(ReadOnlyProtoView(message, nullptr),
+                                       name));
+           })
+      .def("WhichOneof",
+           [](LazyProtoMessage& self, const std::string& name) -> py::object {
+             const Message* message = self.message();
+             if (message == nullptr) {
+               return self.Materialize().attr("WhichOneof")(name);
+             }
+             return WhichOneof(ReadOnlyProtoView(message, nullptr), name);
+           })
+      .def("ByteSize",
+           [](LazyProtoMessage& self) -> py::object {
+             const Message* message = self.message();
+             if (message == nullptr) {
+               return self.Materialize().attr("ByteSize")();
+             }
+             return py::int_(message->ByteSizeLong());
+           })
+      .def("SerializeToString",
+           [](LazyProtoMessage& self) -> py::object {
+             const Message* message = self.message();
+             if (message == nullptr) {
+               return self.Materialize().attr("SerializeToString")();
+             }
+             if (!message->IsInitialized()) {
+               throw py::value_error(
+                   "Message " + message->GetDescriptor()->full_name() +
+                   " is missing required fields: " +
+                   message->InitializationErrorString());
+             }
+             return py::bytes(message->SerializeAsString());
+           })
+      .def("SerializePartialToString",
+           [](LazyProtoMessage& self) -> py::object {
+             const Message* message = self.message();
+             if (message == nullptr) {
+               return self.Materialize().attr("SerializePartialToString")();
+             }
+             return py::bytes(message->SerializePartialAsString());
+           })
+      .def("materialize", &LazyProtoMessage::Materialize,
+           "Returns the python message, converting the C++ message on first "
+           "use.")
+      .def_property_readonly("DESCRIPTOR",
+                             [](LazyProtoMessage& self) -> py::object {
+                               const Message* message = self.message();
+                               if (message == nullptr) {
+                                 return self.Materialize().attr("DESCRIPTOR");
+                               }
+                               return PyDescriptorOf(*message);
+                             })
+      // isinstance() falls back to __class__, which materializes.
+      .def_property_readonly("__class__", [](LazyProtoMessage& self) {
+        return py::type::of(self.Materialize());
+      });
+  lazy_type.store(reinterpret_cast<PyTypeObject*>(cls.release().ptr()));
+}
+
+void RegisterViewTypes() {
+  assert(PyGILState_Check());
+  // The types are module_local, as each extension module links its own copy
+  // of the casters; the scope only provides the python __module__.
+  auto scope =
+      py::reinterpret_steal<py::module_>(PyModule_New("pybind11_protobuf"));
+  RegisterLazyType(scope);
+  py::class_<RepeatedFieldBuffer>(scope, "RepeatedFieldBuffer",
+                                  py::buffer_protocol(), py::module_local())
+      .def_buffer([](const RepeatedFieldBuffer& self) {
+        return py::buffer_info(const_cast<void*>(self.data), self.itemsize,
+                               self.format, 1, {self.size}, {self.itemsize},
+                               /*readonly=*/true);
+      });
+  py::class_<ReadOnlyProtoView> cls(scope, "ReadOnlyMessageView",
+                                    py::module_local());
+  cls.def("__getattr__", &GetField)
+      .def("__setattr__",
+           [](const ReadOnlyProtoView& self, const std::string& name,
+              py::handle) {
+             throw py::attribute_error(
+                 "Cannot set " + name + ": this " +
+                 self.message().GetDescriptor()->full_name() +
+                 " is a read-only view; use materialize() to get a mutable "
+                 "copy.");
+           })
+      .def("__repr__",
+           [](const ReadOnlyProtoView& self) {
+             return "<read-only " +
+                    self.message().GetDescriptor()->full_name() + ": " +
+                    self.message().ShortDebugString() + ">";
+           })
+      .def("HasField", &HasField)
+      .def("WhichOneof", &WhichOneof)
+      .def("field_buffer", &FieldBuffer, py::arg("name"),
+           "Returns a read-only memoryview over the elements of a repeated "
+           "numeric field, without copying them.")
+      .def("IsInitialized",
+           [](const ReadOnlyProtoView& self) {
+             return self.message().IsInitialized();
+           })
+      .def("ByteSize",
+           [](const ReadOnlyProtoView& self) {
+             return self.message().ByteSizeLong();
+           })
+      .def("SerializeToString",
+           [](const ReadOnlyProtoView& self) {
+             if (!self.message().IsInitialized()) {
+               throw py::value_error(
+                   "Message " + self.message().GetDescriptor()->full_name() +
+                   " is missing required fields: " +
+                   self.message().InitializationErrorString());
+             }
+             return py::bytes(self.message().SerializeAsString());
+           })
+      .def("SerializePartialToString",
+           [](const ReadOnlyProtoView& self) {
+             return py::bytes(self.message().SerializePartialAsString());
+           })
+      .def(
+          "materialize",
+          [](const ReadOnlyProtoView& self) {
+            return py::reinterpret_steal<py::object>(GenericProtoCast(
+                const_cast<Message*>(&self.message()),
+                py::return_value_policy::copy, py::handle(), true));
+          },
+          "Returns a mutable python message with a copy of the contents.")
+      .def_property_readonly("DESCRIPTOR", [](const ReadOnlyProtoView& self) {
+        // Allows PyProtoIsCompatible() to accept views created by other
+        // extension modules, which are then copied via
+        // SerializePartialToString.
+        return PyDescriptorOf(self.message());
+      });
+  view_type.store(reinterpret_cast<PyTypeObject*>(cls.release().ptr()));
+}
+
+void EnsureViewTypes() {
+  if (view_type != nullptr) return;
+#if defined(Py_GIL_DISABLED)
+  // Without the GIL, threads may race to register the types. PyMutex
+  // detaches from the interpreter while waiting, so this cannot deadlock
+  // with python code run by the registration.
+  static PyMutex mutex;
+  PyMutex_Lock(&mutex);
+  if (view_type == nullptr) RegisterViewTypes();
+  PyMutex_Unlock(&mutex);
+#else
+  RegisterViewTypes();
+#endif
+}
+
+}  // namespace
+
+py::handle GenericProtoViewCast(const Message* src, py::handle parent,
+                                std::shared_ptr<const Message> owner) {
+  assert(src != nullptr);
+  assert(PyGILState_Check());
+  EnsureViewTypes();
+
+  py::object result = py::cast(ReadOnlyProtoView(src, std::move(owner)),
+                               py::return_value_policy::move);
+  if (parent) {
+    py::detail::keep_alive_impl(result, parent);
+  }
+  return result.release();
+}
+
+py::handle GenericProtoLazyCast(std::shared_ptr<Message> src) {
+  assert(src != nullptr);
+  assert(PyGILState_Check());
+  EnsureViewTypes();
+  return py::cast(LazyProtoMessage(std::move(src)),
+                  py::return_value_policy::move)
+      .release();
+}
+
+const Message* PyProtoViewGetCppMessagePointer(py::handle src) {
+  if (view_type == nullptr) return nullptr;
+  if (Py_TYPE(src.ptr()) == view_type) {
+    return &src.cast<const ReadOnlyProtoView&>().message();
+  }
+  if (Py_TYPE(src.ptr()) == lazy_type) {
+    return src.cast<const LazyProtoMessage&>().message();
+  }
+  return nullptr;
+}
+
+std::shared_ptr<const Message> PyProtoViewGetOwner(py::handle src) {
+  if (view_type == nullptr || Py_TYPE(src.ptr()) != view_type) {
+    return nullptr;
+  }
+  return src.cast<const ReadOnlyProtoView&>().owner();
+}
+
+}  // namespace pybind11_protobuf
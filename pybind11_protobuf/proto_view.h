@@ -0,0 +1,52 @@
+// IWYU pragma: private, include "pybind11_protobuf/native_proto_caster.h"
+
+#ifndef PYBIND11_PROTOBUF_PROTO_VIEW_H_
+#define PYBIND11_PROTOBUF_PROTO_VIEW_H_
+
+#include <pybind11/pybind11.h>
+#include <pybind11/pytypes.h>
+
+#include <memory>
+
+#include "google/protobuf/message.h"
+
+namespace pybind11_protobuf {
+
+// Returns a read-only python view of a C++ message. The view reads fields
+// directly from `src` via reflection, so nothing is copied; any attempt to
+// set a field raises AttributeError and view.materialize() returns a regular,
+// mutable python message with a copy of the contents.
+// view.field_buffer(name) returns a read-only memoryview over the elements of
+// a repeated numeric field, which numpy.asarray() also reads without copying.
+//
+// `owner`, when set, is held by the view and must keep `src` alive, for
+// example a std::shared_ptr<const Proto> or an aliasing shared_ptr to a
+// submessage. Otherwise `src` must outlive the view; `parent`, when set, is
+// kept alive for as long as the view (see return_value_policy::
+// reference_internal).
+pybind11::handle GenericProtoViewCast(
+    const ::google::protobuf::Message *src, pybind11::handle parent,
+    std::shared_ptr<const ::google::protobuf::Message> owner = nullptr);
+
+// Returns a lazy python message which takes ownership of `src`. Until the
+// lazy message is materialized, singular fields are read from `src` via
+// reflection, and singular submessages are lazy messages as well. Setting a
+// field, reading a repeated field or a method of python messages other than
+// HasField(), WhichOneof(), ByteSize() and Serialize*ToString(), as well as
+// isinstance() and pickling, first move `src` into a regular python message,
+// to which the lazy message then forwards; materialize() returns it.
+pybind11::handle GenericProtoLazyCast(
+    std::shared_ptr<::google::protobuf::Message> src);
+
+// Returns the C++ message viewed by a read-only view, or held by a lazy
+// message which has not been materialized, created by this extension module.
+// Returns nullptr for any other object.
+const ::google::protobuf::Message *PyProtoViewGetCppMessagePointer(pybind11::handle src);
+
+// Returns the owner passed to GenericProtoViewCast() when src is a read-only
+// view created by this extension module, or nullptr.
+std::shared_ptr<const ::google::protobuf::Message> PyProtoViewGetOwner(pybind11::handle src);
+
+}  // namespace pybind11_protobuf
+
+#endif  // PYBIND11_PROTOBUF_PROTO_VIEW_H_
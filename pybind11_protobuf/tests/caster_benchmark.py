@@ -0,0 +1,88 @@
+# Copyright (c) 2023 The Pybind Development Team. All rights reserved.
+#
+# All rights reserved. Use of this source code is governed by a
+# BSD-style license that can be found in the LICENSE file.
+"""Times the python side of the proto casters.
+
+Run with `bazel run -c opt :caster_benchmark`. By default each case is run
+with every python protobuf backend which can be imported; pass
+`--backends=upb,cpp` to restrict them. The C++ side is covered by
+:proto_caster_benchmark.
+"""
+
+import argparse
+import os
+import subprocess
+import sys
+import timeit
+
+_SIZES = (0, 100, 10000)
+_STRING_SIZE = 64 * 1024
+_BACKENDS = ('python', 'upb', 'cpp')
+_CHILD_FLAG = '--child'
+
+
+def _time_per_call_us(fn, *args):
+  count, total = timeit.Timer(lambda: fn(*args)).autorange()
+  return total / count * 1e6
+
+
+def _run_cases():
+  # pylint: disable=g-import-not-at-top
+  from google.protobuf.internal import api_implementation
+  from pybind11_protobuf.tests import caster_benchmark_module as m
+  from pybind11_protobuf.tests import test_pb2
+  # pylint: enable=g-import-not-at-top
+
+  print('api_implementation: %s' % api_implementation.Type())
+  print('%-24s %8s %14s' % ('case', 'size', 'time (us)'))
+
+  def report(case, size, fn, *args):
+    print('%-24s %8d %14.2f' % (case, size, _time_per_call_us(fn, *args)))
+
+  for size in _SIZES:
+    cpp_message = m.make_message(size, _STRING_SIZE)
+    py_message = test_pb2.TestMessage()
+    py_message.ParseFromString(cpp_message.SerializeToString())
+    report('load_native/returned', size, m.load_native, cpp_message)
+    report('load_native/python', size, m.load_native, py_message)
+    report('load_via_bytes/returned', size, m.load_via_bytes, cpp_message)
+    report('load_via_bytes/python', size, m.load_via_bytes, py_message)
+
+    report('make_message', size, m.make_message, size, _STRING_SIZE)
+    report('return_copy', size, m.return_copy, size, _STRING_SIZE)
+    report('return_move', size, m.return_move, size, _STRING_SIZE)
+
+    messages = [test_pb2.IntMessage(value=i) for i in range(size)]
+    report('load_list', size, m.load_list, messages)
+    report('return_vector', size, m.return_vector, size)
+    report('return_repeated', size, m.return_repeated, size)
+
+
+def main():
+  if _CHILD_FLAG in sys.argv:
+    _run_cases()
+    return
+
+  parser = argparse.ArgumentParser(description=__doc__)
+  parser.add_argument(
+      '--backends',
+      default=','.join(_BACKENDS),
+      help='Comma separated python protobuf backends to run.')
+  args = parser.parse_args()
+
+  for backend in args.backends.split(','):
+    print('=== backend: %s' % backend)
+    sys.stdout.flush()
+    env = dict(os.environ, PROTOCOL_BUFFERS_PYTHON_IMPLEMENTATION=backend)
+    result = subprocess.run([sys.executable, __file__, _CHILD_FLAG],
+                            env=env,
+                            check=False)
+    if result.returncode:
+      print('backend %s is not available (exit code %d)' %
+            (backend, result.returncode))
+    print()
+
+
+if __name__ == '__main__':
+  main()
@@ -0,0 +1,112 @@
+// Copyright (c) 2023 The Pybind Development Team. All rights reserved.
+//
+// All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "google/protobuf/repeated_field.h"
+#include "pybind11_protobuf/native_proto_caster.h"
+#include "pybind11_protobuf/tests/test.pb.h"
+
+namespace py = ::pybind11;
+
+namespace {
+
+using pybind11::test::IntMessage;
+using pybind11::test::TestMessage;
+
+TestMessage MakeMessage(int repeated_size, int string_size) {
+  TestMessage msg;
+  msg.set_string_value(std::string(string_size, 'x'));
+  for (int i = 0; i < repeated_size; i++) {
+    msg.add_repeated_int_value(i);
+    msg.add_repeated_int_message()->set_value(i);
+  }
+  return msg;
+}
+
+PYBIND11_MODULE(caster_benchmark_module, m) {
+  pybind11_protobuf::ImportNativeProtoCasters();
+
+  m.def("make_message", &MakeMessage, py::arg("repeated_size"),
+        py::arg("string_size") = 0);
+
+  // Python -> C++.
+
+  // Loads through the native_proto_caster: C++-backed messages are borrowed
+  // or copied in C++, other messages are serialized by python.
+  m.def(
+      "load_native",
+      [](const TestMessage& message) -> std::size_t {
+        return message.repeated_int_value_size();
+      },
+      py::arg("message"));
+
+  // Mimics the original load path, which always serialized into a python
+  // bytes object before parsing.
+  m.def(
+      "load_via_bytes",
+      [](py::handle message) -> std::size_t {
+        py::object wire = message.attr("SerializePartialToString")();
+        TestMessage parsed;
+        if (!parsed.ParsePartialFromArray(PYBIND11_BYTES_AS_STRING(wire.ptr()),
+                                          PYBIND11_BYTES_SIZE(wire.ptr()))) {
+          throw py::value_error("Failed to parse TestMessage");
+        }
+        return parsed.repeated_int_value_size();
+      },
+      py::arg("message"));
+
+  m.def(
+      "load_list",
+      [](const std::vector<IntMessage>& messages) -> std::size_t {
+        return messages.size();
+      },
+      py::arg("messages"));
+
+  // C++ -> python. Each call builds its result, so the cost of MakeMessage
+  // is included; compare against make_message.
+
+  m.def(
+      "return_copy",
+      [](int repeated_size, int string_size) -> py::object {
+        TestMessage msg = MakeMessage(repeated_size, string_size);
+        return py::cast(msg, py::return_value_policy::copy);
+      },
+      py::arg("repeated_size"), py::arg("string_size") = 0);
+
+  m.def(
+      "return_move",
+      [](int repeated_size, int string_size) -> py::object {
+        return py::cast(MakeMessage(repeated_size, string_size),
+                        py::return_value_policy::move);
+      },
+      py::arg("repeated_size"), py::arg("string_size") = 0);
+
+  // Lists are converted one element at a time by pybind11/stl.h, or in one
+  // batch by the RepeatedPtrField caster.
+  m.def(
+      "return_vector",
+      [](int size) {
+        std::vector<IntMessage> result(size);
+        for (int i = 0; i < size; i++) result[i].set_value(i);
+        return result;
+      },
+      py::arg("size"));
+  m.def(
+      "return_repeated",
+      [](int size) {
+        ::google::protobuf::RepeatedPtrField<IntMessage> result;
+        for (int i = 0; i < size; i++) result.Add()->set_value(i);
+        return result;
+      },
+      py::arg("size"));
+}
+
+}  // namespace
@@ -0,0 +1,69 @@
+# Copyright (c) 2023 The Pybind Development Team. All rights reserved.
+#
+# All rights reserved. Use of this source code is governed by a
+# BSD-style license that can be found in the LICENSE file.
+"""Tests for the conversion statistics of the casters."""
+
+from absl.testing import absltest
+
+from google.protobuf.internal import api_implementation
+from pybind11_protobuf import caster_stats
+from pybind11_protobuf.tests import message_module
+
+_PATHS = ('borrow', 'swap', 'copy_from', 'serialize', 'field_copy',
+          'unknown_field_check')
+_INT_MESSAGE = 'pybind11.test.IntMessage'
+
+
+def _paths(stats):
+  return {path: stats[path] for path in _PATHS}
+
+
+class CasterStatsTest(absltest.TestCase):
+
+  def setUp(self):
+    super().setUp()
+    caster_stats.reset()
+    self.addCleanup(caster_stats.enable, False)
+
+  def test_disabled_by_default(self):
+    message_module.make_int_message()
+    self.assertEqual(caster_stats.stats(), {})
+
+  def test_records_conversions(self):
+    caster_stats.enable()
+    for i in range(5):
+      self.assertEqual(message_module.make_int_message(i).value, i)
+    stats = caster_stats.stats()
+    self.assertIn(_INT_MESSAGE, stats)
+    int_stats = stats[_INT_MESSAGE]
+    self.assertEqual(sum(int_stats['latency_us']), 5)
+    if api_implementation.Type() == 'cpp' and int_stats['serialize'] == 0:
+      # Through the PyProto_API, returned messages are checked for unknown
+      # fields and swapped into C++ backed python messages.
+      expected = {'swap': 5, 'unknown_field_check': 5}
+      expected_bytes = 0
+    else:
+      # IntMessage(value=0) is empty, the other four take 2 bytes.
+      expected = {'serialize': 5}
+      expected_bytes = 8
+    self.assertEqual(_paths(int_stats),
+                     {path: expected.get(path, 0) for path in _PATHS})
+    self.assertEqual(int_stats['bytes'], expected_bytes)
+
+  def test_disable(self):
+    caster_stats.enable()
+    message_module.make_int_message()
+    caster_stats.enable(False)
+    message_module.make_int_message()
+    self.assertEqual(sum(caster_stats.stats()[_INT_MESSAGE]['latency_us']), 1)
+
+  def test_reset(self):
+    caster_stats.enable()
+    message_module.make_int_message()
+    caster_stats.reset()
+    self.assertEqual(caster_stats.stats(), {})
+
+
+if __name__ == '__main__':
+  absltest.main()
@@ -0,0 +1,65 @@
+// Copyright (c) 2023 The Pybind Development Team. All rights reserved.
+//
+// All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "pybind11_protobuf/delimited_message_io.h"
+#include "pybind11_protobuf/native_proto_caster.h"
+#include "pybind11_protobuf/tests/test.pb.h"
+
+namespace py = ::pybind11;
+
+namespace {
+
+using pybind11::test::IntMessage;
+using pybind11::test::TestMessage;
+
+PYBIND11_MODULE(delimited_io_module, m) {
+  pybind11_protobuf::ImportNativeProtoCasters();
+  // The test protos are compiled into this module, so the reader and writer
+  // registered here parse and serialize them in C++.
+  pybind11_protobuf::RegisterDelimitedMessageIO(m);
+
+  m.def(
+      "sum_int_message_values",
+      [](py::handle source) {
+        int64_t sum = 0;
+        pybind11_protobuf::ReadDelimitedMessages<IntMessage>(
+            source, [&](const IntMessage& message) { sum += message.value(); });
+        return sum;
+      },
+      py::arg("source"));
+
+  m.def(
+      "repeated_int_value_sizes",
+      [](py::handle source) {
+        std::vector<int> sizes;
+        pybind11_protobuf::ReadDelimitedMessages<TestMessage>(
+            source, [&](const TestMessage& message) {
+              sizes.push_back(message.repeated_int_value_size());
+            });
+        return sizes;
+      },
+      py::arg("source"));
+
+  m.def(
+      "write_int_messages",
+      [](py::handle sink, int count) {
+        pybind11_protobuf::DelimitedOutputSink output(sink);
+        IntMessage message;
+        for (int i = 0; i < count; ++i) {
+          message.set_value(i);
+          output.WriteMessage(message);
+        }
+        output.Flush();
+      },
+      py::arg("sink"), py::arg("count"));
+}
+
+}  // namespace
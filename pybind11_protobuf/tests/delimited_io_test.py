@@ -0,0 +1,294 @@
+# Copyright (c) 2023 The Pybind Development Team. All rights reserved.
+#
+# All rights reserved. Use of this source code is governed by a
+# BSD-style license that can be found in the LICENSE file.
+"""Tests for the length-delimited message reader and writer."""
+
+import io
+import mmap
+import os
+import tempfile
+
+from absl.testing import absltest
+from absl.testing import parameterized
+
+from google.protobuf import descriptor_pool
+from google.protobuf import message_factory
+from google.protobuf.internal import encoder
+from pybind11_protobuf import delimited_io
+from pybind11_protobuf.tests import delimited_io_module
+from pybind11_protobuf.tests import test_pb2
+
+# delimited_io_module has the test protos compiled in, delimited_io does not
+# and falls back to FromString() / SerializeToString().
+_MODULES = (('compiled_in', delimited_io_module), ('python', delimited_io))
+
+
+def _delimited(messages):
+  chunks = []
+  for message in messages:
+    wire = message.SerializeToString()
+    chunks.append(encoder._VarintBytes(len(wire)) + wire)  # pylint: disable=protected-access
+  return b''.join(chunks)
+
+
+def _int_messages(count):
+  return [test_pb2.IntMessage(value=i) for i in range(count)]
+
+
+def _varying_messages(count):
+  """Messages whose unset fields and shorter repeated fields expose merging."""
+  messages = []
+  for i in range(count):
+    message = test_pb2.TestMessage()
+    if i % 2 == 0:
+      message.int_value = i + 1
+      message.string_value = 'even'
+      message.int_message.value = i
+    message.repeated_int_value.extend(range(count - i))
+    messages.append(message)
+  return messages
+
+
+class DelimitedIoTest(parameterized.TestCase):
+
+  @parameterized.named_parameters(_MODULES)
+  def test_read_bytes(self, m):
+    reader = m.DelimitedMessageReader(
+        _delimited(_int_messages(10)), test_pb2.IntMessage)
+    messages = reader.read()
+    self.assertLen(messages, 10)
+    self.assertIsInstance(messages[0], test_pb2.IntMessage)
+    self.assertEqual([x.value for x in messages], list(range(10)))
+    self.assertEqual(reader.read(), [])
+
+  @parameterized.named_parameters(_MODULES)
+  def test_read_in_chunks(self, m):
+    reader = m.DelimitedMessageReader(
+        memoryview(_delimited(_int_messages(10))),
+        test_pb2.IntMessage,
+        chunk_size=3)
+    self.assertEqual([x.value for x in reader.read(4)], [0, 1, 2, 3])
+    self.assertEqual([x.value for x in reader.read(4)], [4, 5, 6, 7])
+    self.assertEqual([x.value for x in reader.read(4)], [8, 9])
+    self.assertEqual(reader.read(4), [])
+
+  @parameterized.named_parameters(_MODULES)
+  def test_read_chunks_replace_messages(self, m):
+    messages = _varying_messages(10)
+    reader = m.DelimitedMessageReader(
+        _delimited(messages), test_pb2.TestMessage, chunk_size=3)
+    read = []
+    for chunk in iter(lambda: reader.read(3), []):
+      read.extend(chunk)
+    self.assertEqual(read, messages)
+    reader = m.DelimitedMessageReader(
+        _delimited(messages), test_pb2.TestMessage, chunk_size=2)
+    self.assertEqual(list(reader), messages)
+
+  @parameterized.named_parameters(_MODULES)
+  def test_iterate(self, m):
+    reader = m.DelimitedMessageReader(
+        _delimited(_int_messages(10)), test_pb2.IntMessage, chunk_size=4)
+    self.assertEqual([x.value for x in reader], list(range(10)))
+
+  @parameterized.named_parameters(_MODULES)
+  def test_read_file_object(self, m):
+    data = _delimited(_int_messages(1000))
+    with m.DelimitedMessageReader(io.BytesIO(data),
+                                  test_pb2.IntMessage) as reader:
+      self.assertEqual([x.value for x in reader], list(range(1000)))
+
+  @parameterized.named_parameters(_MODULES)
+  def test_read_fd_and_mmap(self, m):
+    with tempfile.TemporaryFile() as f:
+      f.write(_delimited(_int_messages(100)))
+      f.flush()
+      f.seek(0)
+      reader = m.DelimitedMessageReader(f.fileno(), test_pb2.IntMessage)
+      self.assertLen(reader.read(), 100)
+      with mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ) as mapped:
+        reader = m.DelimitedMessageReader(mapped, test_pb2.IntMessage)
+        self.assertEqual([x.value for x in reader.read()], list(range(100)))
+        reader.close()
+
+  @parameterized.named_parameters(_MODULES)
+  def test_truncated_raises(self, m):
+    data = _delimited([test_pb2.IntMessage(value=3)])
+    reader = m.DelimitedMessageReader(data[:-1], test_pb2.IntMessage)
+    with self.assertRaises(ValueError):
+      reader.read()
+
+  @parameterized.named_parameters(_MODULES)
+  def test_truncated_returns_parsed_prefix(self, m):
+    data = _delimited(_int_messages(5))[:-1]
+    reader = m.DelimitedMessageReader(data, test_pb2.IntMessage)
+    self.assertEqual([x.value for x in reader.read()], [0, 1, 2, 3])
+    with self.assertRaises(ValueError):
+      reader.read()
+    read = []
+    with self.assertRaises(ValueError):
+      for message in m.DelimitedMessageReader(
+          data, test_pb2.IntMessage, chunk_size=3):
+        read.append(message.value)
+    self.assertEqual(read, [0, 1, 2, 3])
+
+  @parameterized.named_parameters(_MODULES)
+  def test_read_other_pool(self, m):
+    # A class of another pool shares the name of the compiled-in IntMessage,
+    # and must not be read as the default pool class.
+    pool = descriptor_pool.DescriptorPool()
+    pool.AddSerializedFile(test_pb2.DESCRIPTOR.serialized_pb)
+    prototype = message_factory.MessageFactory(pool).GetPrototype(
+        pool.FindMessageTypeByName('pybind11.test.IntMessage'))
+    reader = m.DelimitedMessageReader(_delimited(_int_messages(3)), prototype)
+    messages = reader.read()
+    self.assertEqual([type(x) for x in messages], [prototype] * 3)
+    self.assertEqual([x.value for x in messages], [0, 1, 2])
+    seq = m.LazyMessageSequence(_delimited(_int_messages(3)), prototype)
+    self.assertIsInstance(seq[1], prototype)
+
+  @parameterized.named_parameters(_MODULES)
+  def test_closed_raises(self, m):
+    reader = m.DelimitedMessageReader(b'', test_pb2.IntMessage)
+    reader.close()
+    with self.assertRaises(ValueError):
+      reader.read()
+
+  @parameterized.named_parameters(_MODULES)
+  def test_write_read_round_trip(self, m):
+    messages = [
+        test_pb2.TestMessage(string_value='x' * i, repeated_int_value=[i])
+        for i in range(50)
+    ]
+    out = io.BytesIO()
+    with m.DelimitedMessageWriter(out) as writer:
+      writer.write(messages[0])
+      writer.write_all(messages[1:])
+    self.assertEqual(out.getvalue(), _delimited(messages))
+    reader = m.DelimitedMessageReader(out.getvalue(), test_pb2.TestMessage)
+    self.assertEqual(reader.read(), messages)
+
+  @parameterized.named_parameters(_MODULES)
+  def test_write_fd(self, m):
+    with tempfile.TemporaryFile() as f:
+      writer = m.DelimitedMessageWriter(f.fileno())
+      writer.write_all(_int_messages(5))
+      writer.close()
+      f.seek(0)
+      self.assertEqual(f.read(), _delimited(_int_messages(5)))
+
+  @parameterized.named_parameters(_MODULES)
+  def test_write_error_propagates(self, m):
+
+    class FailingFile:
+
+      def write(self, data):
+        del data
+        raise OSError('disk full')
+
+    writer = m.DelimitedMessageWriter(FailingFile())
+    writer.write(test_pb2.IntMessage(value=1))
+    with self.assertRaisesRegex(OSError, 'disk full'):
+      writer.flush()
+
+  def test_invalid_source(self):
+    with self.assertRaises(TypeError):
+      delimited_io.DelimitedMessageReader(1.5, test_pb2.IntMessage)
+
+  def test_cpp_callback(self):
+    data = _delimited(_int_messages(100))
+    self.assertEqual(delimited_io_module.sum_int_message_values(data), 4950)
+    self.assertEqual(
+        delimited_io_module.sum_int_message_values(io.BytesIO(data)), 4950)
+
+  def test_cpp_callback_replaces_messages(self):
+    messages = _varying_messages(6)
+    self.assertEqual(
+        delimited_io_module.repeated_int_value_sizes(_delimited(messages)),
+        [len(message.repeated_int_value) for message in messages])
+
+  def test_cpp_writer(self):
+    out = io.BytesIO()
+    delimited_io_module.write_int_messages(out, 10)
+    self.assertEqual(out.getvalue(), _delimited(_int_messages(10)))
+    r, w = os.pipe()
+    delimited_io_module.write_int_messages(w, 3)
+    os.close(w)
+    with os.fdopen(r, 'rb') as f:
+      self.assertEqual(f.read(), _delimited(_int_messages(3)))
+
+
+
+class LazyMessageSequenceTest(parameterized.TestCase):
+
+  @parameterized.named_parameters(_MODULES)
+  def test_index(self, m):
+    seq = m.LazyMessageSequence(
+        _delimited(_int_messages(10)), test_pb2.IntMessage)
+    self.assertLen(seq, 10)
+    self.assertIsInstance(seq[0], test_pb2.IntMessage)
+    self.assertEqual(seq[3].value, 3)
+    self.assertEqual(seq[-1].value, 9)
+    with self.assertRaises(IndexError):
+      _ = seq[10]
+    with self.assertRaises(IndexError):
+      _ = seq[-11]
+    self.assertEqual([x.value for x in seq], list(range(10)))
+
+  @parameterized.named_parameters(_MODULES)
+  def test_slice(self, m):
+    seq = m.LazyMessageSequence(
+        _delimited(_int_messages(10)), test_pb2.IntMessage)
+    self.assertEqual([x.value for x in seq[2:8:3]], [2, 5])
+    self.assertEqual([x.value for x in seq[::-4]], [9, 5, 1])
+    self.assertEqual(seq[5:2], [])
+
+  @parameterized.named_parameters(_MODULES)
+  def test_repr(self, m):
+    self.assertEqual(
+        repr(m.LazyMessageSequence(b'', test_pb2.IntMessage)), '[]')
+    seq = m.LazyMessageSequence(
+        _delimited(_int_messages(3)[1:]), test_pb2.IntMessage)
+    self.assertEqual(repr(seq), '[value: 1, value: 2]')
+    seq = m.LazyMessageSequence(
+        _delimited(_int_messages(13)[1:]), test_pb2.IntMessage)
+    self.assertEqual(
+        repr(seq),
+        '[' + ', '.join('value: %d' % i for i in range(1, 11)) +
+        ', ..., 2 more]')
+
+  @parameterized.named_parameters(_MODULES)
+  def test_mmap(self, m):
+    with tempfile.TemporaryFile() as f:
+      f.write(_delimited(_int_messages(1000)))
+      f.flush()
+      with mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ) as mapped:
+        seq = m.LazyMessageSequence(mapped, test_pb2.IntMessage)
+        self.assertEqual(seq[999].value, 999)
+        del seq
+
+  @parameterized.named_parameters(_MODULES)
+  def test_repeated_field(self, m):
+    message = test_pb2.TestMessage(
+        string_value='x',
+        repeated_int_value=[1, 2],
+        repeated_int_message=_int_messages(5),
+        int_message=test_pb2.IntMessage(value=7))
+    seq = m.LazyMessageSequence.from_repeated_field(
+        message.SerializeToString(), test_pb2.TestMessage,
+        'repeated_int_message')
+    self.assertLen(seq, 5)
+    self.assertEqual(list(seq), list(message.repeated_int_message))
+    with self.assertRaises(ValueError):
+      m.LazyMessageSequence.from_repeated_field(b'', test_pb2.TestMessage,
+                                                'int_message')
+
+  @parameterized.named_parameters(_MODULES)
+  def test_truncated_raises(self, m):
+    with self.assertRaises(ValueError):
+      m.LazyMessageSequence(
+          _delimited(_int_messages(3))[:-1], test_pb2.IntMessage)
+
+if __name__ == '__main__':
+  absltest.main()
@@ -15,40 +15,42 @@
 #include "google/protobuf/message.h"
 #include "google/protobuf/text_format.h"
 #include "pybind11_protobuf/native_proto_caster.h"
+#include "pybind11_protobuf/proto_cast_util.h"
 
 namespace py = ::pybind11;
 
 namespace {
 
-// GetDynamicPool contains a dynamic message that is wire-compatible with
-// with IntMessage; conversion using the fast_cpp_proto api will fail
-// as the PyProto_API will not be able to find the proto in the default
-// pool.
-::google::protobuf::DescriptorPool* GetDynamicPool() {
-  static ::google::protobuf::DescriptorPool* pool = [] {
-    ::google::protobuf::FileDescriptorProto file_proto;
-    if (!::google::protobuf::TextFormat::ParseFromString(
-            R"pb(
-              name: 'pybind11_protobuf/tests'
-              package: 'pybind11.test'
-              message_type: {
-                name: 'DynamicMessage'
-                field: { name: 'value' number: 1 type: TYPE_INT32 }
-              }
-              message_type: {
-                name: 'IntMessage'
-                field: { name: 'value' number: 1 type: TYPE_INT32 }
-              }
-            )pb",
-            &file_proto)) {
-      throw std::invalid_argument("Failed to parse textproto.");
-    }
-
-    ::google::protobuf::DescriptorPool* pool = new ::google::protobuf::DescriptorPool();
-    pool->BuildFile(file_proto);
-    return pool;
-  }();
+// BuildDynamicPool returns a pool with a dynamic message that is
+// wire-compatible with IntMessage; conversion using the fast_cpp_proto api
+// will fail as the PyProto_API will not be able to find the proto in the
+// default pool.
+std::unique_ptr<::google::protobuf::DescriptorPool> BuildDynamicPool() {
+  ::google::protobuf::FileDescriptorProto file_proto;
+  if (!::google::protobuf::TextFormat::ParseFromString(
+          R"pb(
+            name: 'pybind11_protobuf/tests'
+            package: 'pybind11.test'
+            message_type: {
+              name: 'DynamicMessage'
+              field: { name: 'value' number: 1 type: TYPE_INT32 }
+            }
+            message_type: {
+              name: 'IntMessage'
+              field: { name: 'value' number: 1 type: TYPE_INT32 }
+            }
+          )pb",
+          &file_proto)) {
+    throw std::invalid_argument("Failed to parse textproto.");
+  }
+
+  auto pool = std::make_unique<::google::protobuf::DescriptorPool>();
+  pool->BuildFile(file_proto);
+  return pool;
+}
 
+::google::protobuf::DescriptorPool* GetDynamicPool() {
+  static ::google::protobuf::DescriptorPool* pool = BuildDynamicPool().release();
   return pool;
 }
 
@@ -81,9 +83,36 @@ std::unique_ptr<::google::protobuf::Message> GetDynamicMessage(const std::string
   return dynamic;
 }
 
+// Casts a DynamicMessage of a newly built pool to python, then releases the
+// python objects cached for the pool and destroys it. Returns the value read
+// back from python.
+int32_t CastFromTemporaryPool(int32_t value) {
+  std::unique_ptr<::google::protobuf::DescriptorPool> pool = BuildDynamicPool();
+  int32_t result;
+  {
+    ::google::protobuf::DynamicMessageFactory factory(pool.get());
+    std::unique_ptr<::google::protobuf::Message> message(
+        factory
+            .GetPrototype(
+                pool->FindMessageTypeByName("pybind11.test.DynamicMessage"))
+            ->New());
+    UpdateMessage(message.get(), value);
+    py::object py_message = py::cast(*message, py::return_value_policy::copy);
+    result = py_message.attr("value").cast<int32_t>();
+  }
+  pybind11_protobuf::ReleaseDescriptorPoolCache(pool.get());
+  return result;
+}
+
 PYBIND11_MODULE(dynamic_message_module, m) {
   pybind11_protobuf::ImportNativeProtoCasters();
 
+  // With a PyProto_API, messages of the dynamic pool are returned in python
+  // messages of the python factory for the same pool: the same Descriptor,
+  // but a different Reflection than the messages of GetDynamicMessage().
+  m.attr("HAS_PY_PROTO_API") =
+      py::bool_(pybind11_protobuf::GetPyProtoApi() != nullptr);
+
   //  Message building methods.
   m.def(
       "dynamic_message_ptr",
@@ -106,7 +135,17 @@ PYBIND11_MODULE(dynamic_message_module, m) {
       },
       py::arg("name") = "pybind11.test.DynamicMessage", py::arg("value") = 123);
 
+  m.def(
+      "dynamic_message_copy",
+      [](std::string name, int32_t value) -> py::object {
+        std::unique_ptr<::google::protobuf::Message> message = GetDynamicMessage(name, value);
+        if (!message) return py::none();
+        return py::cast(*message, py::return_value_policy::copy);
+      },
+      py::arg("name") = "pybind11.test.DynamicMessage", py::arg("value") = 123);
+
   // Test methods
+  m.def("cast_from_temporary_pool", &CastFromTemporaryPool, py::arg("value"));
   m.def("check_message", &CheckMessage, py::arg("message"), py::arg("value"));
   m.def(
       "check_message_const_ptr",
@@ -14,6 +14,7 @@ from absl.testing import parameterized
 from google.protobuf import descriptor_pb2
 from google.protobuf import descriptor_pool
 from google.protobuf import message_factory
+from pybind11_protobuf import caster_stats
 from pybind11_protobuf.tests import compare
 from pybind11_protobuf.tests import dynamic_message_module as m
 from pybind11_protobuf.tests import test_pb2
@@ -38,6 +39,49 @@ POOL.Add(
                         name='value', number=1, type=5)
                 ])
         ]))
+POOL.Add(
+    descriptor_pb2.FileDescriptorProto(
+        name='pybind11_protobuf/tests/dependent',
+        package='pybind11.test',
+        dependency=['pybind11_protobuf/tests'],
+        message_type=[
+            descriptor_pb2.DescriptorProto(
+                name='DependentMessage',
+                field=[
+                    descriptor_pb2.FieldDescriptorProto(
+                        name='int_message',
+                        number=1,
+                        type=11,
+                        type_name='.pybind11.test.IntMessage')
+                ])
+        ]))
+
+POOL.Add(
+    descriptor_pb2.FileDescriptorProto(
+        name='pybind11_protobuf/tests/extendable',
+        package='pybind11.test',
+        message_type=[
+            descriptor_pb2.DescriptorProto(
+                name='ExtendableMessage',
+                extension_range=[
+                    descriptor_pb2.DescriptorProto.ExtensionRange(
+                        start=100, end=200)
+                ])
+        ]))
+
+# Added to POOL by test_extension_added_after_miss.
+EXTENSION_FILE = descriptor_pb2.FileDescriptorProto(
+    name='pybind11_protobuf/tests/extendable_extension',
+    package='pybind11.test',
+    dependency=['pybind11_protobuf/tests/extendable'],
+    extension=[
+        descriptor_pb2.FieldDescriptorProto(
+            name='extendable_value',
+            number=100,
+            label=1,
+            type=5,
+            extendee='.pybind11.test.ExtendableMessage')
+    ])
 
 
 def get_py_dynamic_message(value=5):
@@ -140,6 +184,59 @@ class DynamicMessageTest(parameterized.TestCase, compare.ProtoAssertions):
     b = m.print_descriptor(a)
     self.assertNotEqual(-1, b.find('value = 1'), b)
 
+  @parameterized.named_parameters(
+      ('move', m.dynamic_message_unique_ptr),
+      ('copy', m.dynamic_message_copy),
+  )
+  def test_cast_path_of_own_factory_message(self, make_message):
+    # With a PyProto_API, the python message has the Descriptor of the C++
+    # message and another Reflection, so its contents are copied through
+    # reflection. Otherwise the default pool IntMessage is parsed from the
+    # serialized message.
+    caster_stats.reset()
+    caster_stats.enable()
+    self.addCleanup(caster_stats.enable, False)
+    message = make_message('pybind11.test.IntMessage', 11)
+    self.assertEqual(message.value, 11)
+    self.assertEqual(str(message.DESCRIPTOR.full_name),
+                     'pybind11.test.IntMessage')
+    stats = caster_stats.stats()['pybind11.test.IntMessage']
+    if m.HAS_PY_PROTO_API:
+      self.assertEqual((stats['copy_from'], stats['serialize']), (1, 0))
+    else:
+      self.assertEqual((stats['copy_from'], stats['serialize']), (0, 1))
+    self.assertEqual(stats['swap'], 0)
+
+  def test_print_dependent_file(self):
+    prototype = FACTORY.CreatePrototype(
+        POOL.FindMessageTypeByName('pybind11.test.DependentMessage'))
+    a = prototype()
+    a.int_message.value = 7
+    # The first conversion fetches the file along with its dependency; the
+    # second one is served from the wrapped pool.
+    for _ in range(2):
+      b = m.print(a)
+      self.assertIn('value: 7', b)
+
+  def test_extension_added_after_miss(self):
+    prototype = FACTORY.CreatePrototype(
+        POOL.FindMessageTypeByName('pybind11.test.ExtendableMessage'))
+    # Field 100, a varint of 5.
+    a = prototype.FromString(b'\xa0\x06\x05')
+    # Unknown to C++, like it is to python.
+    self.assertEqual(m.print(a).strip(), '100: 5')
+    # Once registered with the python pool, the extension is found by the
+    # next conversion.
+    POOL.Add(EXTENSION_FILE)
+    self.assertEqual(
+        m.print(a).strip(), '[pybind11.test.extendable_value]: 5')
+
+  def test_release_descriptor_pool_cache(self):
+    # Each call casts from a new C++ pool, which may reuse the address of the
+    # pool destroyed by the previous call.
+    for value in range(5):
+      self.assertEqual(m.cast_from_temporary_pool(value), value)
+
 
 if __name__ == '__main__':
   absltest.main()
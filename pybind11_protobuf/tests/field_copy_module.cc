@@ -0,0 +1,35 @@
+// Copyright (c) 2023 The Pybind Development Team. All rights reserved.
+//
+// All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include <pybind11/pybind11.h>
+
+#include "pybind11_protobuf/native_proto_caster.h"
+#include "pybind11_protobuf/tests/test.pb.h"
+
+namespace py = ::pybind11;
+
+using pybind11::test::IntMessage;
+using pybind11::test::TestMessage;
+
+namespace {
+
+PYBIND11_MODULE(field_copy_module, m) {
+  pybind11_protobuf::ImportNativeProtoCasters();
+
+  m.def(
+      "serialize_test_message",
+      [](const TestMessage& message) {
+        return py::bytes(message.SerializeAsString());
+      },
+      py::arg("message"));
+  m.def(
+      "serialize_int_message",
+      [](const IntMessage& message) {
+        return py::bytes(message.SerializeAsString());
+      },
+      py::arg("message"));
+}
+
+}  // namespace
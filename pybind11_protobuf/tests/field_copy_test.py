@@ -0,0 +1,91 @@
+# Copyright (c) 2023 The Pybind Development Team. All rights reserved.
+#
+# All rights reserved. Use of this source code is governed by a
+# BSD-style license that can be found in the LICENSE file.
+"""Tests field by field copies of pure python messages into C++.
+
+Run with PROTOCOL_BUFFERS_PYTHON_IMPLEMENTATION=python.
+"""
+
+from absl.testing import absltest
+
+from google.protobuf.internal import api_implementation
+from pybind11_protobuf import caster_stats
+from pybind11_protobuf.tests import field_copy_module as m
+from pybind11_protobuf.tests import test_pb2
+
+_TEST_MESSAGE = 'pybind11.test.TestMessage'
+_INT_MESSAGE = 'pybind11.test.IntMessage'
+
+
+def _large_message():
+  message = test_pb2.TestMessage(
+      string_value='large',
+      int_value=-4,
+      double_value=1.5,
+      repeated_int_value=range(1000),
+      enum_value=test_pb2.TestMessage.TWO,
+      repeated_enum_value=[
+          test_pb2.TestMessage.ONE, test_pb2.TestMessage.TWO
+      ],
+      oneof_b=2.5)
+  message.int_message.value = 3
+  message.nested.value = 7
+  for i in range(3):
+    message.repeated_int_message.add(value=i)
+  message.string_int_map['a'] = 1
+  message.string_int_map['b'] = 2
+  message.int_message_map[1].value = 5
+  return message
+
+
+def _paths(full_name):
+  return caster_stats.stats().get(full_name, {})
+
+
+class FieldCopyTest(absltest.TestCase):
+
+  def setUp(self):
+    super().setUp()
+    if api_implementation.Type() != 'python':
+      self.skipTest('Field copies are only used with the python backend.')
+    caster_stats.reset()
+    caster_stats.enable()
+    self.addCleanup(caster_stats.enable, False)
+
+  def test_large_message_copied_by_field(self):
+    message = _large_message()
+    copied = test_pb2.TestMessage.FromString(
+        m.serialize_test_message(message))
+    self.assertEqual(copied, message)
+    self.assertEqual(_paths(_TEST_MESSAGE).get('field_copy'), 1)
+    self.assertEqual(_paths(_TEST_MESSAGE).get('serialize'), 0)
+
+  def test_long_repeated_field_copied_by_field(self):
+    message = test_pb2.TestMessage(repeated_int_value=range(-20, 20))
+    copied = test_pb2.TestMessage.FromString(
+        m.serialize_test_message(message))
+    self.assertEqual(list(copied.repeated_int_value), list(range(-20, 20)))
+    self.assertEqual(_paths(_TEST_MESSAGE).get('field_copy'), 1)
+
+  def test_small_message_serialized(self):
+    message = test_pb2.IntMessage(value=9)
+    copied = test_pb2.IntMessage.FromString(m.serialize_int_message(message))
+    self.assertEqual(copied, message)
+    self.assertEqual(_paths(_INT_MESSAGE).get('field_copy'), 0)
+    self.assertEqual(_paths(_INT_MESSAGE).get('serialize'), 1)
+
+  def test_message_with_unknown_fields_serialized(self):
+    # Field 100, a varint of 1, is not part of TestMessage.
+    unknown_field = b'\xa0\x06\x01'
+    message = test_pb2.TestMessage.FromString(
+        _large_message().SerializeToString() + unknown_field)
+    serialized = m.serialize_test_message(message)
+    self.assertTrue(serialized.endswith(unknown_field))
+    self.assertEqual(test_pb2.TestMessage.FromString(serialized), message)
+    self.assertEqual(_paths(_TEST_MESSAGE).get('field_copy'), 0)
+    self.assertEqual(_paths(_TEST_MESSAGE).get('serialize'), 1)
+
+
+if __name__ == '__main__':
+  absltest.main()
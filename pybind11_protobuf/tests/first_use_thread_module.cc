@@ -0,0 +1,54 @@
+// Copyright (c) 2023 The Pybind Development Team. All rights reserved.
+//
+// All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+// Initializes the casters lazily, so that the first conversion, which creates
+// the caster state and imports the python modules, can race between threads.
+
+#include <pybind11/pybind11.h>
+
+#include <string>
+
+#include "pybind11_protobuf/native_proto_caster.h"
+#include "pybind11_protobuf/tests/test.pb.h"
+
+namespace py = ::pybind11;
+
+using pybind11::test::IntMessage;
+using pybind11::test::TestMessage;
+
+namespace {
+
+PYBIND11_MODULE(first_use_thread_module, m) {
+  pybind11_protobuf::ImportNativeProtoCastersLazily();
+
+  m.def(
+      "make_message",
+      [](std::string text) -> TestMessage {
+        TestMessage msg;
+        msg.set_string_value(std::move(text));
+        return msg;
+      },
+      py::arg("text") = "");
+
+  m.def(
+      "make_int_message",
+      [](int value) -> IntMessage {
+        IntMessage msg;
+        msg.set_value(value);
+        return msg;
+      },
+      py::arg("value") = 0);
+
+  m.def(
+      "get_string_value",
+      [](const TestMessage& msg) { return msg.string_value(); },
+      py::arg("message"));
+
+  m.def(
+      "get_value", [](const IntMessage& msg) { return msg.value(); },
+      py::arg("message"));
+}
+
+}  // namespace
@@ -0,0 +1,57 @@
+"""Test the first conversions of pybind11_protobuf from multiple threads.
+
+The module initializes its casters lazily, and this test must not import the
+generated python modules before the threads start, so the threads race to
+create the caster state, import the modules and cache the message classes.
+
+Run with `blaze test :first_use_thread_test --config=tsan`.
+"""
+
+import concurrent.futures
+import threading
+
+from absl.testing import absltest
+from pybind11_protobuf.tests import first_use_thread_module as m
+
+_THREADS = 8
+
+
+def _run_together(fn):
+  barrier = threading.Barrier(_THREADS)
+
+  def run(i):
+    barrier.wait()
+    return fn(i)
+
+  with concurrent.futures.ThreadPoolExecutor(max_workers=_THREADS) as executor:
+    return list(executor.map(run, range(_THREADS)))
+
+
+class FirstUseThreadTest(absltest.TestCase):
+
+  def test_parallel_first_use(self):
+    # First casts to python: creates the state and imports test_pb2.
+    def cast(i):
+      if i % 2:
+        return m.make_int_message(i).value
+      return m.make_message(str(i)).string_value
+
+    self.assertEqual(
+        _run_together(cast),
+        [i if i % 2 else str(i) for i in range(_THREADS)])
+
+    # First casts from python: caches the verdicts per message class.
+    from pybind11_protobuf.tests import test_pb2  # pylint: disable=g-import-not-at-top
+
+    def load(i):
+      if i % 2:
+        return m.get_value(test_pb2.IntMessage(value=i))
+      return m.get_string_value(test_pb2.TestMessage(string_value=str(i)))
+
+    self.assertEqual(
+        _run_together(load),
+        [i if i % 2 else str(i) for i in range(_THREADS)])
+
+
+if __name__ == '__main__':
+  absltest.main()
@@ -0,0 +1,69 @@
+// Copyright (c) 2023 The Pybind Development Team. All rights reserved.
+//
+// All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include <pybind11/pybind11.h>
+
+#include "pybind11_protobuf/native_proto_caster.h"
+#include "pybind11_protobuf/tests/test.pb.h"
+
+namespace pybind11::test {
+
+// Opt TestMessage into lazy conversion; see proto_caster_impl.h.
+constexpr bool pybind11_protobuf_enable_lazy_conversion(TestMessage*) {
+  return true;
+}
+
+}  // namespace pybind11::test
+
+namespace py = ::pybind11;
+
+namespace {
+
+using pybind11::test::IntMessage;
+using pybind11::test::TestMessage;
+
+TestMessage MakeMessage() {
+  TestMessage message;
+  message.set_string_value("lazy");
+  message.set_int_value(5);
+  message.mutable_int_message()->set_value(6);
+  message.add_repeated_int_value(1);
+  message.add_repeated_int_value(2);
+  (*message.mutable_string_int_map())["k"] = 8;
+  message.set_enum_value(TestMessage::TWO);
+  message.set_oneof_b(1.5);
+  return message;
+}
+
+const TestMessage* last_owned = nullptr;
+
+PYBIND11_MODULE(lazy_message_module, m) {
+  pybind11_protobuf::ImportNativeProtoCastersLazily();
+
+  m.def("make_message", &MakeMessage);
+  m.def(
+      "make_owned_message",
+      []() {
+        auto* message = new TestMessage(MakeMessage());
+        last_owned = message;
+        return message;
+      },
+      py::return_value_policy::take_ownership);
+  m.def(
+      "is_last_owned",
+      [](const TestMessage* message) { return message == last_owned; },
+      py::arg("message"));
+
+  m.def(
+      "get_int_value",
+      [](const TestMessage& message) { return message.int_value(); },
+      py::arg("message"));
+  m.def(
+      "get_value",
+      [](const IntMessage& message) { return message.value(); },
+      py::arg("message"));
+}
+
+}  // namespace
@@ -0,0 +1,93 @@
+# Copyright (c) 2023 The Pybind Development Team. All rights reserved.
+#
+# All rights reserved. Use of this source code is governed by a
+# BSD-style license that can be found in the LICENSE file.
+"""Tests for lazy conversion of returned protos."""
+
+import copy
+import pickle
+
+from absl.testing import absltest
+
+from google.protobuf.internal import api_implementation
+from pybind11_protobuf.tests import lazy_message_module as m
+from pybind11_protobuf.tests import test_pb2
+
+
+class LazyMessageTest(absltest.TestCase):
+
+  def test_read_singular_fields(self):
+    message = m.make_message()
+    self.assertIsNot(type(message), test_pb2.TestMessage)
+    self.assertEqual(message.string_value, 'lazy')
+    self.assertEqual(message.int_value, 5)
+    self.assertEqual(message.int_message.value, 6)
+    self.assertEqual(message.nested.value, 0)
+    self.assertEqual(message.enum_value, test_pb2.TestMessage.TWO)
+    self.assertTrue(message.HasField('int_message'))
+    self.assertFalse(message.HasField('nested'))
+    self.assertEqual(message.WhichOneof('test_oneof'), 'oneof_b')
+    self.assertIsNot(type(message), test_pb2.TestMessage)
+
+  def test_passes_cpp_message_back(self):
+    message = m.make_owned_message()
+    self.assertEqual(message.int_message.value, 6)
+    self.assertTrue(m.is_last_owned(message))
+    self.assertEqual(m.get_int_value(message), 5)
+    self.assertEqual(m.get_value(message.int_message), 6)
+
+  def test_repeated_fields_materialize(self):
+    message = m.make_message()
+    self.assertEqual(list(message.repeated_int_value), [1, 2])
+    self.assertEqual(dict(message.string_int_map), {'k': 8})
+    message.repeated_int_value.append(3)
+    self.assertEqual(list(message.repeated_int_value), [1, 2, 3])
+
+  def test_assignment_materializes(self):
+    message = m.make_owned_message()
+    nested = message.int_message
+    message.int_value = 7
+    self.assertEqual(message.int_value, 7)
+    self.assertFalse(m.is_last_owned(message))
+    self.assertEqual(m.get_int_value(message), 7)
+    self.assertEqual(nested.value, 6)
+    self.assertEqual(message.string_value, 'lazy')
+
+  def test_submessage_assignment(self):
+    message = m.make_message()
+    message.int_message.value = 9
+    self.assertEqual(message.int_message.value, 9)
+    self.assertEqual(message.materialize().int_message.value, 9)
+    message.nested.value = 1
+    self.assertTrue(message.HasField('nested'))
+
+  def test_isinstance_materializes(self):
+    message = m.make_message()
+    self.assertIsInstance(message, test_pb2.TestMessage)
+    self.assertIsInstance(message.materialize(), test_pb2.TestMessage)
+    self.assertEqual(message.int_value, 5)
+
+  def test_python_message_interop(self):
+    message = m.make_message()
+    expected = test_pb2.TestMessage.FromString(message.SerializeToString())
+    self.assertEqual(message, expected)
+    self.assertEqual(message.ByteSize(), expected.ByteSize())
+    self.assertEqual(message.DESCRIPTOR.full_name, 'pybind11.test.TestMessage')
+    other = test_pb2.TestMessage()
+    if api_implementation.Type() == 'python':
+      other.CopyFrom(message)
+      self.assertEqual(other, expected)
+    else:
+      # See pybind11_protobuf_enable_lazy_conversion.
+      with self.assertRaises(TypeError):
+        other.CopyFrom(message)
+      with self.assertRaises(TypeError):
+        other.MergeFrom(message)
+    other.CopyFrom(message.materialize())
+    self.assertEqual(other, expected)
+    self.assertEqual(copy.deepcopy(message), expected)
+    self.assertEqual(pickle.loads(pickle.dumps(message)), expected)
+
+
+if __name__ == '__main__':
+  absltest.main()
@@ -0,0 +1,62 @@
+// Copyright (c) 2023 The Pybind Development Team. All rights reserved.
+//
+// All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include <pybind11/pybind11.h>
+
+#include <memory>
+
+#include "pybind11_protobuf/native_proto_caster.h"
+#include "pybind11_protobuf/tests/test.pb.h"
+
+namespace pybind11::test {
+
+// Opt TestMessage into arena loads; see proto_caster_impl.h.
+constexpr bool pybind11_protobuf_use_load_arena(TestMessage*) { return true; }
+
+}  // namespace pybind11::test
+
+namespace py = ::pybind11;
+
+namespace {
+
+using pybind11::test::TestMessage;
+
+PYBIND11_MODULE(load_arena_module, m) {
+  pybind11_protobuf::ImportNativeProtoCasters();
+
+  m.def(
+      "is_borrowed",
+      [](py::handle message) {
+        return pybind11_protobuf::PyProtoGetCppMessagePointer(message) !=
+               nullptr;
+      },
+      py::arg("message"));
+  m.def(
+      "serialize",
+      [](const TestMessage& message) {
+        return py::bytes(message.SerializeAsString());
+      },
+      py::arg("message"));
+  m.def(
+      "is_on_arena",
+      [](const TestMessage& message) { return message.GetArena() != nullptr; },
+      py::arg("message"));
+  m.def(
+      "take_by_value",
+      [](TestMessage message) {
+        return py::make_tuple(message.GetArena() != nullptr,
+                              py::bytes(message.SerializeAsString()));
+      },
+      py::arg("message"));
+  m.def(
+      "take_unique_ptr",
+      [](std::unique_ptr<TestMessage> message) {
+        return py::make_tuple(message->GetArena() != nullptr,
+                              py::bytes(message->SerializeAsString()));
+      },
+      py::arg("message"));
+}
+
+}  // namespace
@@ -0,0 +1,57 @@
+# Copyright (c) 2023 The Pybind Development Team. All rights reserved.
+#
+# All rights reserved. Use of this source code is governed by a
+# BSD-style license that can be found in the LICENSE file.
+"""Tests for arena allocated temporary messages of argument loads."""
+
+from absl.testing import absltest
+
+from google.protobuf import text_format
+from pybind11_protobuf.tests import load_arena_module as m
+from pybind11_protobuf.tests import test_pb2
+
+
+def _make_message():
+  return text_format.Parse(
+      """
+      string_value: 'arena'
+      int_value: 5
+      int_message { value: 6 }
+      repeated_int_value: [1, 2, 3]
+      repeated_int_message { value: 7 }
+      string_int_map { key: 'k' value: 8 }
+      """, test_pb2.TestMessage())
+
+
+class LoadArenaTest(absltest.TestCase):
+
+  def test_const_ref_uses_arena(self):
+    message = _make_message()
+    # Messages backed by a compatible C++ message are used in place.
+    self.assertEqual(m.is_on_arena(message), not m.is_borrowed(message))
+    self.assertEqual(m.serialize(message), message.SerializeToString())
+
+  def test_arenas_are_reused(self):
+    # Later calls reuse the arenas of earlier ones, including after a
+    # message outgrew the initial block.
+    for size in (0, 10, 100000, 3, 100000, 0):
+      message = test_pb2.TestMessage(string_value='x' * size)
+      message.repeated_int_value.extend(range(size // 100))
+      self.assertEqual(m.serialize(message), message.SerializeToString())
+
+  def test_take_by_value_copies_out_of_arena(self):
+    message = _make_message()
+    on_arena, serialized = m.take_by_value(message)
+    self.assertFalse(on_arena)
+    self.assertEqual(serialized, message.SerializeToString())
+
+  def test_take_unique_ptr_copies_out_of_arena(self):
+    message = _make_message()
+    for _ in range(2):
+      on_arena, serialized = m.take_unique_ptr(message)
+      self.assertFalse(on_arena)
+      self.assertEqual(serialized, message.SerializeToString())
+
+
+if __name__ == '__main__':
+  absltest.main()
@@ -0,0 +1,31 @@
+// Copyright (c) 2023 The Pybind Development Team. All rights reserved.
+//
+// All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include <pybind11/pybind11.h>
+
+#include "pybind11_protobuf/native_proto_caster.h"
+#include "pybind11_protobuf/tests/import_later.pb.h"
+
+namespace py = ::pybind11;
+
+using pybind11::test::ImportLaterMessage;
+
+namespace {
+
+PYBIND11_MODULE(negative_cache_module, m) {
+  pybind11_protobuf::ImportNativeProtoCasters();
+
+  m.def("make_message", [](int value) -> ImportLaterMessage {
+    ImportLaterMessage message;
+    message.set_value(value);
+    return message;
+  });
+  m.def("preload", [] {
+    pybind11_protobuf::ImportNativeProtoCasters(
+        {ImportLaterMessage::descriptor()});
+  });
+}
+
+}  // namespace
@@ -0,0 +1,84 @@
+# Copyright (c) 2023 The Pybind Development Team. All rights reserved.
+#
+# All rights reserved. Use of this source code is governed by a
+# BSD-style license that can be found in the LICENSE file.
+"""Tests the caching of missing python message classes and failed imports."""
+
+import contextlib
+import importlib
+import os
+import sys
+import tempfile
+
+from absl.testing import absltest
+
+from pybind11_protobuf.tests import negative_cache_module as m
+
+_MODULE_NAME = 'pybind11_protobuf.tests.import_later_pb2'
+
+
+class _BlockImport:
+  """Makes the import of _MODULE_NAME fail until removed from sys.meta_path."""
+
+  def find_spec(self, fullname, path, target=None):
+    del path, target  # Unused.
+    if fullname == _MODULE_NAME:
+      raise ModuleNotFoundError('blocked', name=fullname)
+    return None
+
+
+@contextlib.contextmanager
+def _captured_stderr():
+  """Captures what C++ std::cerr and python sys.stderr print."""
+  output = []
+  sys.stderr.flush()
+  saved = os.dup(2)
+  with tempfile.TemporaryFile() as f:
+    os.dup2(f.fileno(), 2)
+    try:
+      yield output
+    finally:
+      sys.stderr.flush()
+      os.dup2(saved, 2)
+      os.close(saved)
+      f.seek(0)
+      output.append(f.read().decode())
+
+
+class NegativeCacheTest(absltest.TestCase):
+
+  def test_missing_class(self):
+    self.assertNotIn(_MODULE_NAME, sys.modules)
+    blocker = _BlockImport()
+    sys.meta_path.insert(0, blocker)
+    try:
+      with _captured_stderr() as first_output:
+        try:
+          m.preload()
+        except TypeError as e:
+          first_error = str(e)
+        else:
+          self.skipTest('The python descriptor pool provides the class.')
+      # The failed import is reported once, by the module import.
+      self.assertEqual(first_output[0].count(_MODULE_NAME), 1)
+
+      with _captured_stderr() as output:
+        for _ in range(3):
+          with self.assertRaises(TypeError) as context:
+            m.make_message(1)
+          self.assertEqual(str(context.exception), first_error)
+      self.assertEmpty(output[0])
+    finally:
+      sys.meta_path.remove(blocker)
+
+    # Importing the module clears the miss.
+    module = importlib.import_module(_MODULE_NAME)
+    with _captured_stderr() as output:
+      message = m.make_message(2)
+    self.assertIsInstance(message, module.ImportLaterMessage)
+    self.assertEqual(message.value, 2)
+    self.assertEmpty(output[0])
+
+
+if __name__ == '__main__':
+  absltest.main()
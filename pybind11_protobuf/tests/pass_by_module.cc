@@ -16,7 +16,9 @@
 #include "google/protobuf/dynamic_message.h"
 #include "google/protobuf/message.h"
 #include "pybind11_protobuf/native_proto_caster.h"
+#include "pybind11_protobuf/proto_cast_util.h"
 #include "pybind11_protobuf/tests/test.pb.h"
+#include "python/google/protobuf/proto_api.h"
 
 namespace py = ::pybind11;
 
@@ -36,6 +38,23 @@ bool CheckMessage(const ::google::protobuf::Message* message, int32_t value) {
   return message->GetReflection()->GetInt32(*message, f) == value;
 }
 
+// Whether the casters may borrow the C++ message of a python IntMessage.
+// This probes the casters' PyProto_API with IntMessage, rather than the
+// descriptor the casters themselves check, so that a wrong check fails the
+// expectations of pass_by_test.
+bool LoadsBorrowIntMessage() {
+  const auto* py_proto_api = pybind11_protobuf::GetPyProtoApi();
+  if (py_proto_api == nullptr) return false;
+#if defined(PYBIND11_PROTOBUF_ASSUME_FULL_ABI_COMPATIBILITY)
+  return true;
+#else
+  const ::google::protobuf::DescriptorPool* pool = py_proto_api->GetDefaultDescriptorPool();
+  return pool != nullptr &&
+         pool->FindMessageTypeByName(IntMessage::descriptor()->full_name()) ==
+             IntMessage::descriptor();
+#endif
+}
+
 IntMessage* GetStatic() {
   static IntMessage* msg = new IntMessage();
   msg->set_value(4);
@@ -46,6 +65,7 @@ PYBIND11_MODULE(pass_by_module, m) {
   pybind11_protobuf::ImportNativeProtoCasters();
 
   m.attr("PYBIND11_PROTOBUF_UNSAFE") = pybind11::int_(PYBIND11_PROTOBUF_UNSAFE);
+  m.attr("LOADS_BORROW") = pybind11::bool_(LoadsBorrowIntMessage());
 
   m.def(
       "make_int_message",
@@ -279,6 +299,35 @@ PYBIND11_MODULE(pass_by_module, m) {
       py::arg("message"), py::arg("value"));
 #endif
 
+  // repeated fields
+  m.def(
+      "make_repeated_int_message",
+      [](int size) {
+        ::google::protobuf::RepeatedPtrField<IntMessage> result;
+        for (int i = 0; i < size; ++i) result.Add()->set_value(i);
+        return result;
+      },
+      py::arg("size"));
+  m.def(
+      "static_repeated_cref",
+      []() -> const ::google::protobuf::RepeatedPtrField<IntMessage>& {
+        static auto* result = [] {
+          auto* r = new ::google::protobuf::RepeatedPtrField<IntMessage>();
+          r->Add()->set_value(4);
+          r->Add()->set_value(5);
+          return r;
+        }();
+        return *result;
+      });
+  m.def(
+      "repeated_cref",
+      [](const ::google::protobuf::RepeatedPtrField<IntMessage>& messages) {
+        int sum = 0;
+        for (const auto& message : messages) sum += message.value();
+        return sum;
+      },
+      py::arg("messages"));
+
   // overloaded functions
   m.def(
       "fn_overload", [](const IntMessage&) -> int { return 2; },
@@ -10,6 +10,7 @@ from __future__ import print_function
 from absl.testing import absltest
 from absl.testing import parameterized
 
+from pybind11_protobuf import caster_stats
 from pybind11_protobuf.tests import pass_by_module as m
 from pybind11_protobuf.tests import test_pb2
 from google.protobuf import descriptor_pool
@@ -119,6 +120,21 @@ class PassByTest(parameterized.TestCase):
     message = prototype(value=9)
     self.assertTrue(check_method(message, 9))
 
+  def test_load_borrows_when_pools_are_shared(self):
+    # Without PYBIND11_PROTOBUF_ASSUME_FULL_ABI_COMPATIBILITY, loads borrow
+    # only when the runtime check finds that python shares the generated pool.
+    caster_stats.reset()
+    caster_stats.enable()
+    self.addCleanup(caster_stats.enable, False)
+    self.assertTrue(m.concrete_cref(test_pb2.IntMessage(value=3), 3))
+    stats = caster_stats.stats()['pybind11.test.IntMessage']
+    if m.LOADS_BORROW:
+      self.assertEqual(stats['borrow'], 1)
+      self.assertEqual(stats['serialize'] + stats['field_copy'], 0)
+    else:
+      self.assertEqual(stats['borrow'], 0)
+      self.assertEqual(stats['serialize'] + stats['field_copy'], 1)
+
   def test_pass_none(self):
     self.assertFalse(m.concrete_cptr(None, 1))
     self.assertFalse(m.abstract_cptr(None, 2))
@@ -170,6 +186,49 @@ class PassByTest(parameterized.TestCase):
   def test_overload_fn(self, message_fn, expected):
     self.assertEqual(expected, m.fn_overload(message_fn()))
 
+  def test_overload_fn_repeated(self):
+    # Verdicts are cached per message class; repeated calls must agree.
+    for _ in range(3):
+      self.assertEqual(2, m.fn_overload(test_pb2.IntMessage()))
+      self.assertEqual(1, m.fn_overload(test_pb2.TestMessage()))
+
+  def test_overload_fn_collected_class(self):
+    # Classes from a private pool are not compatible with the compiled-in
+    # IntMessage. They are collected along with their pool, after which a
+    # new class may reuse the address of the old one.
+    for _ in range(3):
+      pool = descriptor_pool.DescriptorPool()
+      pool.AddSerializedFile(test_pb2.DESCRIPTOR.serialized_pb)
+      prototype = message_factory.MessageFactory(pool).GetPrototype(
+          pool.FindMessageTypeByName('pybind11.test.IntMessage'))
+      self.assertEqual(1, m.fn_overload(prototype()))
+      del prototype, pool
+      self.assertEqual(2, m.fn_overload(test_pb2.IntMessage()))
+
+  def test_make_repeated(self):
+    messages = m.make_repeated_int_message(3)
+    self.assertIsInstance(messages, list)
+    self.assertEqual([0, 1, 2], [message.value for message in messages])
+    self.assertEqual([], m.make_repeated_int_message(0))
+
+  def test_static_repeated_cref(self):
+    messages = m.static_repeated_cref()
+    self.assertEqual([4, 5], [message.value for message in messages])
+    messages[0].value = 10
+    self.assertEqual(4, m.static_repeated_cref()[0].value)
+
+  def test_pass_repeated(self):
+    messages = [test_pb2.IntMessage(value=v) for v in (1, 2, 3)]
+    self.assertEqual(6, m.repeated_cref(messages))
+    self.assertEqual(6, m.repeated_cref(tuple(messages)))
+    self.assertEqual(0, m.repeated_cref([]))
+
+  def test_pass_repeated_wrong_type(self):
+    with self.assertRaises(TypeError):
+      m.repeated_cref([test_pb2.TestMessage()])
+    with self.assertRaises(TypeError):
+      m.repeated_cref(b'')
+
 
 if __name__ == '__main__':
   absltest.main()
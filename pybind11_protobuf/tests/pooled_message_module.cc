@@ -0,0 +1,46 @@
+// Copyright (c) 2023 The Pybind Development Team. All rights reserved.
+//
+// All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include <pybind11/pybind11.h>
+
+#include <memory>
+
+#include "pybind11_protobuf/native_proto_caster.h"
+#include "pybind11_protobuf/tests/test.pb.h"
+
+namespace pybind11::test {
+
+// Opt TestMessage into pooled loads; see proto_caster_impl.h.
+constexpr bool pybind11_protobuf_pool_load_messages(TestMessage*) {
+  return true;
+}
+
+}  // namespace pybind11::test
+
+namespace py = ::pybind11;
+
+namespace {
+
+using pybind11::test::TestMessage;
+
+PYBIND11_MODULE(pooled_message_module, m) {
+  pybind11_protobuf::ImportNativeProtoCasters();
+
+  m.def(
+      "serialize",
+      [](const TestMessage& message) {
+        return py::bytes(message.SerializeAsString());
+      },
+      py::arg("message"));
+  m.def(
+      "take_by_value",
+      [](TestMessage message) { return message; }, py::arg("message"));
+  m.def(
+      "take_unique_ptr",
+      [](std::unique_ptr<TestMessage> message) { return message; },
+      py::arg("message"));
+}
+
+}  // namespace
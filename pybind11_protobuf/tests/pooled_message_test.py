@@ -0,0 +1,53 @@
+# Copyright (c) 2023 The Pybind Development Team. All rights reserved.
+#
+# All rights reserved. Use of this source code is governed by a
+# BSD-style license that can be found in the LICENSE file.
+"""Tests for pooled temporary messages of argument loads."""
+
+from absl.testing import absltest
+
+from google.protobuf import text_format
+from pybind11_protobuf.tests import pooled_message_module as m
+from pybind11_protobuf.tests import test_pb2
+
+
+def _make_message():
+  return text_format.Parse(
+      """
+      string_value: 'pooled'
+      int_value: 5
+      int_message { value: 6 }
+      repeated_int_value: [1, 2, 3]
+      string_int_map { key: 'k' value: 8 }
+      """, test_pb2.TestMessage())
+
+
+class PooledMessageTest(absltest.TestCase):
+
+  def test_reused_messages_are_cleared(self):
+    message = _make_message()
+    self.assertEqual(m.serialize(message), message.SerializeToString())
+    empty = test_pb2.TestMessage()
+    self.assertEqual(m.serialize(empty), b'')
+    partial = test_pb2.TestMessage(int_value=7)
+    self.assertEqual(m.serialize(partial), partial.SerializeToString())
+
+  def test_repeated_calls(self):
+    for i in range(10):
+      message = test_pb2.TestMessage(int_value=i)
+      message.repeated_int_value.extend(range(i))
+      self.assertEqual(m.serialize(message), message.SerializeToString())
+
+  def test_take_by_value(self):
+    message = _make_message()
+    self.assertEqual(m.take_by_value(message), message)
+    self.assertEqual(m.serialize(test_pb2.TestMessage()), b'')
+
+  def test_take_unique_ptr(self):
+    message = _make_message()
+    self.assertEqual(m.take_unique_ptr(message), message)
+    self.assertEqual(m.take_unique_ptr(message), message)
+
+
+if __name__ == '__main__':
+  absltest.main()
@@ -0,0 +1,42 @@
+// Copyright (c) 2023 The Pybind Development Team. All rights reserved.
+//
+// All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include <pybind11/pybind11.h>
+
+#include "pybind11_protobuf/native_proto_caster.h"
+#include "pybind11_protobuf/tests/test.pb.h"
+
+namespace py = ::pybind11;
+
+namespace {
+
+using pybind11::test::IntMessage;
+using pybind11::test::TestMessage;
+
+PYBIND11_MODULE(preload_module, m) {
+  // Imports pybind11_protobuf.tests.test_pb2 and caches the classes of the
+  // returned types, in one batch and then one by one.
+  pybind11_protobuf::ImportNativeProtoCasters(
+      {TestMessage::descriptor(), TestMessage::Nested::descriptor()});
+  pybind11_protobuf::PreloadProtoMessageClass<IntMessage>();
+
+  m.def("make_test_message", [](int value) {
+    TestMessage message;
+    message.set_int_value(value);
+    return message;
+  });
+  m.def("make_nested", [](int value) {
+    TestMessage::Nested message;
+    message.set_value(value);
+    return message;
+  });
+  m.def("make_int_message", [](int value) {
+    IntMessage message;
+    message.set_value(value);
+    return message;
+  });
+}
+
+}  // namespace
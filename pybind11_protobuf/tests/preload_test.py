@@ -0,0 +1,37 @@
+# Copyright (c) 2023 The Pybind Development Team. All rights reserved.
+#
+# All rights reserved. Use of this source code is governed by a
+# BSD-style license that can be found in the LICENSE file.
+"""Tests for preloading message classes when importing the casters."""
+
+import sys
+
+from absl.testing import absltest
+
+# test_pb2 is deliberately not imported here: importing preload_module must
+# import it.
+from pybind11_protobuf.tests import preload_module as m
+
+_TEST_PB2 = 'pybind11_protobuf.tests.test_pb2'
+
+
+class PreloadTest(absltest.TestCase):
+
+  def test_import_imports_message_module(self):
+    self.assertIn(_TEST_PB2, sys.modules)
+
+  def test_preloaded_types(self):
+    test_pb2 = sys.modules[_TEST_PB2]
+    message = m.make_test_message(3)
+    self.assertIsInstance(message, test_pb2.TestMessage)
+    self.assertEqual(message.int_value, 3)
+    nested = m.make_nested(4)
+    self.assertIsInstance(nested, test_pb2.TestMessage.Nested)
+    self.assertEqual(nested.value, 4)
+    int_message = m.make_int_message(5)
+    self.assertIsInstance(int_message, test_pb2.IntMessage)
+    self.assertEqual(int_message.value, 5)
+
+
+if __name__ == '__main__':
+  absltest.main()
@@ -0,0 +1,202 @@
+// Copyright (c) 2023 The Pybind Development Team. All rights reserved.
+//
+// All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+// Benchmarks for the C++ side of the proto casters, run inside an embedded
+// python interpreter. The python protobuf backend is selected as usual, for
+// example with PROTOCOL_BUFFERS_PYTHON_IMPLEMENTATION=upb; the python side is
+// covered by caster_benchmark.py. The embedded interpreter needs to be able to
+// import google.protobuf, so PYTHONPATH may need to be set.
+//
+// The benchmarks use FileDescriptorProto, which is compiled into the protobuf
+// runtime, is available to python as descriptor_pb2, and contains extendable
+// *Options messages which exercise check_unknown_fields.
+
+#include <pybind11/embed.h>
+#include <pybind11/pybind11.h>
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "google/protobuf/descriptor.pb.h"
+#include "google/protobuf/message.h"
+#include "pybind11_protobuf/check_unknown_fields.h"
+#include "pybind11_protobuf/native_proto_caster.h"
+#include "pybind11_protobuf/wrapped_proto_caster.h"
+
+namespace py = ::pybind11;
+
+namespace {
+
+using ::google::protobuf::FieldDescriptorProto;
+using ::google::protobuf::FileDescriptorProto;
+
+// Builds a FileDescriptorProto with `size` message types of four fields.
+FileDescriptorProto MakeMessage(int size) {
+  FileDescriptorProto file;
+  file.set_name("benchmark.proto");
+  file.set_package("pybind11.benchmark");
+  for (int i = 0; i < size; ++i) {
+    auto* message = file.add_message_type();
+    message->set_name("Message" + std::to_string(i));
+    message->mutable_options()->set_deprecated(false);
+    for (int j = 0; j < 4; ++j) {
+      auto* field = message->add_field();
+      field->set_name("field_" + std::to_string(j));
+      field->set_number(j + 1);
+      field->set_type(FieldDescriptorProto::TYPE_STRING);
+      field->set_label(FieldDescriptorProto::LABEL_OPTIONAL);
+    }
+  }
+  return file;
+}
+
+void SetMessageSizeCounters(benchmark::State& state,
+                            const ::google::protobuf::Message& message) {
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          message.ByteSizeLong());
+}
+
+// proto_caster_load_impl::load from a message returned by C++, which may be
+// borrowed when backed by a compatible C++ message.
+void BM_LoadReturned(benchmark::State& state) {
+  FileDescriptorProto message = MakeMessage(state.range(0));
+  py::object py_message = py::cast(message);
+  for (auto _ : state) {
+    pybind11_protobuf::proto_caster_load_impl<FileDescriptorProto> loader;
+    benchmark::DoNotOptimize(loader.load(py_message, /*convert=*/false));
+  }
+  SetMessageSizeCounters(state, message);
+}
+BENCHMARK(BM_LoadReturned)->Arg(0)->Arg(100)->Arg(10000);
+
+// proto_caster_load_impl::load from a message constructed in python.
+void BM_LoadPython(benchmark::State& state) {
+  FileDescriptorProto message = MakeMessage(state.range(0));
+  py::object py_message =
+      py::module_::import("google.protobuf.descriptor_pb2")
+          .attr("FileDescriptorProto")();
+  py_message.attr("MergeFromString")(py::bytes(message.SerializeAsString()));
+  for (auto _ : state) {
+    pybind11_protobuf::proto_caster_load_impl<FileDescriptorProto> loader;
+    benchmark::DoNotOptimize(loader.load(py_message, /*convert=*/false));
+  }
+  SetMessageSizeCounters(state, message);
+}
+BENCHMARK(BM_LoadPython)->Arg(0)->Arg(100)->Arg(10000);
+
+void BM_GenericPyProtoCast(benchmark::State& state) {
+  FileDescriptorProto message = MakeMessage(state.range(0));
+  for (auto _ : state) {
+    auto result = py::reinterpret_steal<py::object>(
+        pybind11_protobuf::GenericPyProtoCast(
+            &message, py::return_value_policy::copy, py::handle(), false));
+    benchmark::DoNotOptimize(result.ptr());
+  }
+  SetMessageSizeCounters(state, message);
+}
+BENCHMARK(BM_GenericPyProtoCast)->Arg(0)->Arg(100)->Arg(10000);
+
+void BM_GenericFastCppProtoCast(benchmark::State& state,
+                                py::return_value_policy policy) {
+  // Decided by the casters' own state, which is also null when the casters
+  // were built without the PyProto_API.
+  if (pybind11_protobuf::GetPyProtoApi() == nullptr) {
+    state.SkipWithError("The casters do not use a PyProto_API");
+    return;
+  }
+  const FileDescriptorProto prototype = MakeMessage(state.range(0));
+  FileDescriptorProto message = prototype;
+  const bool consumes_source = policy == py::return_value_policy::move ||
+                               policy == py::return_value_policy::take_ownership;
+  for (auto _ : state) {
+    if (consumes_source) {
+      state.PauseTiming();
+      message = prototype;
+      state.ResumeTiming();
+    }
+    // take_ownership hands over a heap allocated message in real code; the
+    // cast itself swaps the contents, like move.
+    auto result = py::reinterpret_steal<py::object>(
+        pybind11_protobuf::GenericFastCppProtoCast(&message, policy,
+                                                   py::handle(), false));
+    benchmark::DoNotOptimize(result.ptr());
+  }
+  SetMessageSizeCounters(state, prototype);
+}
+BENCHMARK_CAPTURE(BM_GenericFastCppProtoCast, copy,
+                  py::return_value_policy::copy)
+    ->Arg(0)
+    ->Arg(100)
+    ->Arg(10000);
+BENCHMARK_CAPTURE(BM_GenericFastCppProtoCast, move,
+                  py::return_value_policy::move)
+    ->Arg(0)
+    ->Arg(100)
+    ->Arg(10000);
+BENCHMARK_CAPTURE(BM_GenericFastCppProtoCast, take_ownership,
+                  py::return_value_policy::take_ownership)
+    ->Arg(0)
+    ->Arg(100)
+    ->Arg(10000);
+BENCHMARK_CAPTURE(BM_GenericFastCppProtoCast, reference,
+                  py::return_value_policy::reference)
+    ->Arg(0)
+    ->Arg(100)
+    ->Arg(10000);
+
+// wrapped_proto_vector_caster::cast for a list of small messages.
+void BM_WrappedProtoVectorCast(benchmark::State& state) {
+  const std::vector<FileDescriptorProto> prototype(state.range(0),
+                                                   MakeMessage(1));
+  for (auto _ : state) {
+    state.PauseTiming();
+    std::vector<FileDescriptorProto> messages = prototype;
+    pybind11_protobuf::WrappedProtoVector<FileDescriptorProto> wrapped(
+        std::move(messages));
+    state.ResumeTiming();
+    auto result = py::reinterpret_steal<py::object>(
+        pybind11_protobuf::wrapped_proto_vector_caster<
+            FileDescriptorProto>::cast(std::move(wrapped),
+                                       py::return_value_policy::move,
+                                       py::handle()));
+    benchmark::DoNotOptimize(result.ptr());
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) *
+                          state.range(0));
+}
+BENCHMARK(BM_WrappedProtoVectorCast)->Arg(1)->Arg(100)->Arg(10000);
+
+void BM_CheckUnknownFields(benchmark::State& state) {
+  // Decided by the casters' own state, which is also null when the casters
+  // were built without the PyProto_API.
+  if (pybind11_protobuf::GetPyProtoApi() == nullptr) {
+    state.SkipWithError("The casters do not use a PyProto_API");
+    return;
+  }
+  FileDescriptorProto message = MakeMessage(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        pybind11_protobuf::check_unknown_fields::CheckAndBuildErrorMessageIfAny(
+            pybind11_protobuf::GetPyProtoApi(), &message));
+  }
+  SetMessageSizeCounters(state, message);
+}
+BENCHMARK(BM_CheckUnknownFields)->Arg(0)->Arg(100)->Arg(10000);
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+
+  py::scoped_interpreter interpreter;
+  pybind11_protobuf::ImportNativeProtoCasters();
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return 0;
+}
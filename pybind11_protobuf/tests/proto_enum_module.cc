@@ -4,10 +4,12 @@
 // BSD-style license that can be found in the LICENSE file.
 
 #include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
 
 #include <functional>
 #include <memory>
 #include <stdexcept>
+#include <vector>
 
 #include "pybind11_protobuf/enum_type_caster.h"
 #include "pybind11_protobuf/tests/test.pb.h"
@@ -78,6 +80,18 @@ PYBIND11_MODULE(proto_enum_module, m) {
         }
       },
       py::arg("enum"));
+
+  m.def(
+      "adjust_enums",
+      [](const std::vector<TestMessage::TestEnum>& values) {
+        std::vector<TestMessage::TestEnum> result;
+        result.reserve(values.size());
+        for (TestMessage::TestEnum e : values) {
+          result.push_back(static_cast<TestMessage::TestEnum>((e + 1) % 3));
+        }
+        return result;
+      },
+      py::arg("enums"));
 }
 
 }  // namespace
@@ -23,6 +23,15 @@ class ProtoEnumTest(absltest.TestCase):
     with self.assertRaises(TypeError):
       m.adjust_enum('ZERO')
 
+  def test_enum_list(self):
+    self.assertEqual(
+        m.adjust_enums([0, test_pb2.TestMessage.ONE, m.TWO]), [1, 2, 0])
+    self.assertEqual(m.adjust_enums([]), [])
+    with self.assertRaises(TypeError):
+      m.adjust_enums([0, 2**40])
+    with self.assertRaises(TypeError):
+      m.adjust_enums([0, 'ONE'])
+
   def test_another_enum(self):
     self.assertEqual(m.adjust_another_enum(m.AnotherEnum.ZERO), 11)
     self.assertEqual(
@@ -0,0 +1,38 @@
+// Copyright (c) 2023 The Pybind Development Team. All rights reserved.
+//
+// All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+// Exercises proto_utils.h. Messages cross the C++/python boundary serialized,
+// since proto_utils and the native casters are not used together.
+
+#include <pybind11/pybind11.h>
+
+#include "pybind11_protobuf/proto_utils.h"
+#include "pybind11_protobuf/tests/test.pb.h"
+
+namespace py = ::pybind11;
+
+namespace {
+
+using pybind11::test::IntMessage;
+using pybind11::test::TestMessage;
+
+PYBIND11_MODULE(proto_utils_module, m) {
+  m.def(
+      "init_test_message",
+      [](py::kwargs kwargs) {
+        TestMessage message;
+        py::google::ProtoInitFields(&message, kwargs);
+        return py::bytes(message.SerializeAsString());
+      },
+      "Returns a serialized TestMessage initialized from the keyword "
+      "arguments.");
+  m.def("init_int_message", [](py::kwargs kwargs) {
+    IntMessage message;
+    py::google::ProtoInitFields(&message, kwargs);
+    return py::bytes(message.SerializeAsString());
+  });
+}
+
+}  // namespace
@@ -0,0 +1,113 @@
+# Copyright (c) 2023 The Pybind Development Team. All rights reserved.
+#
+# All rights reserved. Use of this source code is governed by a
+# BSD-style license that can be found in the LICENSE file.
+"""Tests for the field containers of proto_utils."""
+
+import array
+import threading
+
+from absl.testing import absltest
+
+from pybind11_protobuf.tests import proto_utils_module as m
+from pybind11_protobuf.tests import test_pb2
+
+
+def _init(**kwargs):
+  return test_pb2.TestMessage.FromString(m.init_test_message(**kwargs))
+
+
+class ProtoUtilsTest(absltest.TestCase):
+
+  def test_scalar_fields(self):
+    message = _init(int_value=5, string_value='abc', double_value=1.5)
+    self.assertEqual(message,
+                     test_pb2.TestMessage(
+                         int_value=5, string_value='abc', double_value=1.5))
+
+  def test_repeated_from_sequence(self):
+    self.assertEqual(
+        list(_init(repeated_int_value=[1, 2, 3]).repeated_int_value),
+        [1, 2, 3])
+
+  def test_repeated_from_buffer(self):
+    values = array.array('i', range(1000))
+    self.assertEqual(
+        list(_init(repeated_int_value=values).repeated_int_value),
+        list(values))
+    self.assertEqual(
+        list(_init(repeated_int_value=memoryview(values)).repeated_int_value),
+        list(values))
+
+  def test_repeated_from_incompatible_buffer(self):
+    # Falls back to converting element by element.
+    self.assertEqual(
+        list(_init(repeated_int_value=array.array('q', [1, 2]))
+             .repeated_int_value), [1, 2])
+    self.assertEqual(
+        list(_init(repeated_int_value=memoryview(
+            array.array('i', range(6)))[::2]).repeated_int_value), [0, 2, 4])
+
+  def test_repeated_enum(self):
+    message = _init(repeated_enum_value=[1, 2, 0])
+    self.assertEqual(list(message.repeated_enum_value), [1, 2, 0])
+
+  def test_map(self):
+    values = {'key%d' % i: i for i in range(1000)}
+    message = _init(string_int_map=values)
+    self.assertEqual(dict(message.string_int_map), values)
+
+  def test_message_map(self):
+    message = _init(int_message_map={
+        1: test_pb2.IntMessage(value=10),
+        2: test_pb2.IntMessage(),
+    })
+    self.assertEqual(message.int_message_map[1].value, 10)
+    self.assertIn(2, message.int_message_map)
+    self.assertLen(message.int_message_map, 2)
+
+  def test_map_inserts_into_populated_map(self):
+    # Each item is inserted into a map which already holds the earlier ones,
+    # through the key index of the update.
+    values = {}
+    for i in range(500):
+      values[i] = test_pb2.IntMessage(value=i * 2)
+    message = _init(int_message_map=values)
+    self.assertLen(message.int_message_map, 500)
+    for i in range(500):
+      self.assertEqual(message.int_message_map[i].value, i * 2)
+    self.assertEqual(message.SerializeToString(deterministic=True),
+                     test_pb2.TestMessage(int_message_map=values)
+                     .SerializeToString(deterministic=True))
+
+  def test_map_invalid_value_raises(self):
+    with self.assertRaises(TypeError):
+      m.init_test_message(string_int_map={'a': 'not an int'})
+
+  def test_concurrent_first_use(self):
+    # The first use of each message type builds its field accessor table.
+    results = []
+
+    def init():
+      results.append(m.init_test_message(int_value=1, string_value='a'))
+      results.append(m.init_int_message(value=2))
+
+    threads = [threading.Thread(target=init) for _ in range(8)]
+    for thread in threads:
+      thread.start()
+    for thread in threads:
+      thread.join()
+    self.assertLen(results, 16)
+    self.assertCountEqual(
+        results,
+        [test_pb2.TestMessage(int_value=1, string_value='a')
+         .SerializeToString(),
+         test_pb2.IntMessage(value=2).SerializeToString()] * 8)
+
+  def test_unknown_field_raises(self):
+    with self.assertRaises(AttributeError):
+      m.init_test_message(no_such_field=1)
+
+
+if __name__ == '__main__':
+  absltest.main()
@@ -0,0 +1,88 @@
+// Copyright (c) 2023 The Pybind Development Team. All rights reserved.
+//
+// All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include <pybind11/pybind11.h>
+
+#include <memory>
+
+#include "pybind11_protobuf/native_proto_caster.h"
+#include "pybind11_protobuf/tests/test.pb.h"
+
+namespace pybind11::test {
+
+// Opt TestMessage into read-only views; see proto_caster_impl.h.
+constexpr bool pybind11_protobuf_enable_read_only_views(TestMessage*) {
+  return true;
+}
+
+}  // namespace pybind11::test
+
+namespace py = ::pybind11;
+
+namespace {
+
+using pybind11::test::TestMessage;
+
+class ConfigHolder {
+ public:
+  ConfigHolder() {
+    config_.set_string_value("config");
+    config_.set_int_value(5);
+    config_.mutable_int_message()->set_value(6);
+    config_.add_repeated_int_value(1);
+    config_.add_repeated_int_value(2);
+    config_.add_repeated_int_message()->set_value(7);
+    (*config_.mutable_string_int_map())["k"] = 8;
+    (*config_.mutable_int_message_map())[9].set_value(10);
+    config_.set_enum_value(TestMessage::TWO);
+    config_.set_oneof_b(1.5);
+  }
+
+  const TestMessage& config() const { return config_; }
+  void set_int_value(int value) { config_.set_int_value(value); }
+
+ private:
+  TestMessage config_;
+};
+
+const std::shared_ptr<const TestMessage>& SharedConfig() {
+  static auto* config = new std::shared_ptr<const TestMessage>(
+      std::make_shared<const TestMessage>(ConfigHolder().config()));
+  return *config;
+}
+
+PYBIND11_MODULE(read_only_view_module, m) {
+  pybind11_protobuf::ImportNativeProtoCasters();
+
+  py::class_<ConfigHolder>(m, "ConfigHolder")
+      .def(py::init<>())
+      .def("config", &ConfigHolder::config,
+           py::return_value_policy::reference_internal)
+      .def("config_copy", &ConfigHolder::config)
+      .def("set_int_value", &ConfigHolder::set_int_value)
+      .def(
+          "is_config",
+          [](const ConfigHolder& holder, const TestMessage* message) {
+            return message == &holder.config();
+          },
+          py::arg("message"));
+
+  m.def("shared_config", &SharedConfig);
+  m.def("shared_config_use_count",
+        []() { return SharedConfig().use_count() - 1; });
+  m.def(
+      "is_shared_config",
+      [](std::shared_ptr<const TestMessage> message) {
+        return message == SharedConfig();
+      },
+      py::arg("message"));
+
+  m.def(
+      "get_int_value",
+      [](const TestMessage& message) { return message.int_value(); },
+      py::arg("message"));
+}
+
+}  // namespace
@@ -0,0 +1,126 @@
+# Copyright (c) 2023 The Pybind Development Team. All rights reserved.
+#
+# All rights reserved. Use of this source code is governed by a
+# BSD-style license that can be found in the LICENSE file.
+"""Tests for read-only views of const proto references."""
+
+import gc
+
+from absl.testing import absltest
+
+from pybind11_protobuf.tests import read_only_view_module as m
+from pybind11_protobuf.tests import test_pb2
+
+
+class ReadOnlyViewTest(absltest.TestCase):
+
+  def test_default_policy_copies(self):
+    holder = m.ConfigHolder()
+    config = holder.config_copy()
+    self.assertIsInstance(config, test_pb2.TestMessage)
+    config.int_value = 1
+    self.assertEqual(m.get_int_value(holder.config()), 5)
+
+  def test_read_fields(self):
+    view = m.ConfigHolder().config()
+    self.assertNotIsInstance(view, test_pb2.TestMessage)
+    self.assertEqual(view.string_value, 'config')
+    self.assertEqual(view.int_value, 5)
+    self.assertEqual(view.int_message.value, 6)
+    self.assertEqual(view.repeated_int_value, (1, 2))
+    self.assertEqual([x.value for x in view.repeated_int_message], [7])
+    self.assertEqual(view.string_int_map, {'k': 8})
+    self.assertEqual(view.int_message_map[9].value, 10)
+    self.assertEqual(view.enum_value, test_pb2.TestMessage.TWO)
+    self.assertEqual(view.oneof_b, 1.5)
+    self.assertEqual(view.nested.value, 0)
+
+  def test_presence(self):
+    view = m.ConfigHolder().config()
+    self.assertTrue(view.HasField('int_message'))
+    self.assertFalse(view.HasField('nested'))
+    self.assertTrue(view.HasField('test_oneof'))
+    self.assertEqual(view.WhichOneof('test_oneof'), 'oneof_b')
+    with self.assertRaises(ValueError):
+      view.HasField('int_value')
+    with self.assertRaises(AttributeError):
+      _ = view.no_such_field
+
+  def test_assignment_raises(self):
+    view = m.ConfigHolder().config()
+    with self.assertRaises(AttributeError):
+      view.int_value = 1
+    with self.assertRaises(AttributeError):
+      view.int_message.value = 1
+
+  def test_field_buffer(self):
+    view = m.ConfigHolder().config()
+    buffer = view.field_buffer('repeated_int_value')
+    self.assertTrue(buffer.readonly)
+    self.assertEqual(buffer.format, 'i')
+    self.assertEqual(buffer.tolist(), [1, 2])
+    with self.assertRaises(TypeError):
+      buffer[0] = 3
+    self.assertEqual(view.field_buffer('repeated_enum_value').tolist(), [])
+    with self.assertRaises(TypeError):
+      view.field_buffer('int_value')
+    with self.assertRaises(TypeError):
+      view.field_buffer('repeated_int_message')
+    with self.assertRaises(AttributeError):
+      view.field_buffer('no_such_field')
+
+  def test_field_buffer_keeps_message_alive(self):
+    buffer = m.ConfigHolder().config().field_buffer('repeated_int_value')
+    gc.collect()
+    self.assertEqual(buffer.tolist(), [1, 2])
+
+  def test_view_aliases_cpp_message(self):
+    holder = m.ConfigHolder()
+    view = holder.config()
+    holder.set_int_value(11)
+    self.assertEqual(view.int_value, 11)
+    self.assertTrue(holder.is_config(view))
+    self.assertEqual(m.get_int_value(view), 11)
+
+  def test_view_keeps_parent_alive(self):
+    view = m.ConfigHolder().config()
+    nested = view.int_message
+    del view
+    gc.collect()
+    self.assertEqual(nested.value, 6)
+
+  def test_materialize(self):
+    view = m.ConfigHolder().config()
+    message = view.materialize()
+    self.assertIsInstance(message, test_pb2.TestMessage)
+    self.assertEqual(message.SerializeToString(), view.SerializeToString())
+    message.int_value = 1
+    self.assertEqual(view.int_value, 5)
+
+  def test_serialize_and_descriptor(self):
+    view = m.ConfigHolder().config()
+    message = test_pb2.TestMessage.FromString(view.SerializePartialToString())
+    self.assertEqual(message.int_message.value, 6)
+    self.assertEqual(view.DESCRIPTOR.full_name, 'pybind11.test.TestMessage')
+
+  def test_shared_const_ptr_shares_ownership(self):
+    base_count = m.shared_config_use_count()
+    view = m.shared_config()
+    self.assertNotIsInstance(view, test_pb2.TestMessage)
+    self.assertEqual(view.int_value, 5)
+    self.assertEqual(m.shared_config_use_count(), base_count + 1)
+    nested = view.int_message
+    self.assertEqual(m.shared_config_use_count(), base_count + 2)
+    del view, nested
+    gc.collect()
+    self.assertEqual(m.shared_config_use_count(), base_count)
+
+  def test_shared_const_ptr_round_trip(self):
+    view = m.shared_config()
+    self.assertTrue(m.is_shared_config(view))
+    self.assertFalse(m.is_shared_config(view.materialize()))
+    self.assertFalse(m.is_shared_config(test_pb2.TestMessage()))
+
+
+if __name__ == '__main__':
+  absltest.main()
@@ -6,9 +6,11 @@
 #include <pybind11/pybind11.h>
 
 #include <cstddef>
+#include <string>
 
 #include "google/protobuf/message.h"
 #include "pybind11_protobuf/native_proto_caster.h"
+#include "pybind11_protobuf/tests/test.pb.h"
 
 PYBIND11_MODULE(very_large_proto_module, m) {
   pybind11_protobuf::ImportNativeProtoCasters();
@@ -18,4 +20,16 @@ PYBIND11_MODULE(very_large_proto_module, m) {
           const ::google::protobuf::Reflection* refl = msg.GetReflection();
           return refl != nullptr ? refl->SpaceUsedLong(msg) : 0;
         });
+
+  m.def("release_gil_for_large_protos",
+        &pybind11_protobuf::ReleaseGilForLargeProtos);
+  m.def("make_test_message", [](std::size_t string_size) {
+    pybind11::test::TestMessage msg;
+    msg.set_string_value(std::string(string_size, 'x'));
+    return msg;
+  });
+  m.def("get_string_value_size",
+        [](const pybind11::test::TestMessage& msg) -> std::size_t {
+          return msg.string_value().size();
+        });
 }
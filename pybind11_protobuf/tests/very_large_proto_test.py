@@ -21,6 +21,18 @@ class MessageTest(absltest.TestCase):
     space_used_estimate = m.get_space_used_estimate(msg)
     self.assertGreater(space_used_estimate, msg_size)
 
+  def test_release_gil_for_large_protos(self):
+    m.release_gil_for_large_protos(1024)
+    try:
+      for size in (10, 1024 * 1024):
+        msg = m.make_test_message(size)
+        self.assertLen(msg.string_value, size)
+        self.assertEqual(m.get_string_value_size(msg), size)
+        py_msg = test_pb2.TestMessage(string_value=msg.string_value)
+        self.assertEqual(m.get_string_value_size(py_msg), size)
+    finally:
+      m.release_gil_for_large_protos(0)
+
 
 if __name__ == '__main__':
   absltest.main()
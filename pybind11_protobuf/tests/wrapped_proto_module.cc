@@ -148,6 +148,10 @@ PYBIND11_MODULE(wrapped_proto_module, m) {
           return result;
         }),
         py::arg("value") = 123);
+
+  m.def("load_proto_vectors_in_parallel",
+        &pybind11_protobuf::LoadProtoVectorsInParallel, py::arg("batch_size"),
+        py::arg("max_threads"));
 }
 
 /// Below here are compile tests for fast_cpp_proto_casters
@@ -8,6 +8,8 @@ from __future__ import absolute_import
 from __future__ import division
 from __future__ import print_function
 
+import threading
+
 from absl.testing import absltest
 from absl.testing import parameterized
 
@@ -75,6 +77,38 @@ class WrappedProtoTest(parameterized.TestCase, compare.ProtoAssertions):
     self.assertEqual(2, m.check_int_message_list(a, 34))
     self.assertEqual(2, m.check_int_message_list(a, 33))
 
+  def test_check_list_in_parallel(self):
+    m.load_proto_vectors_in_parallel(batch_size=8, max_threads=4)
+    try:
+      a = [test_pb2.IntMessage(value=i % 3) for i in range(100)]
+      a.append(m.make_int_message(value=2))
+      self.assertEqual(34, m.check_int_message_list(a, 2))
+      self.assertEqual(34, m.take_int_message_list(a, 2))
+      with self.assertRaises(TypeError):
+        m.check_int_message_list(a + [test_pb2.TestMessage()], 2)
+    finally:
+      m.load_proto_vectors_in_parallel(batch_size=0, max_threads=0)
+
+  def test_check_list_in_parallel_from_threads(self):
+    # Concurrent loads share the pool of parsing threads.
+    m.load_proto_vectors_in_parallel(batch_size=4, max_threads=3)
+    try:
+      a = [test_pb2.IntMessage(value=i % 2) for i in range(64)]
+      results = []
+
+      def check():
+        for _ in range(20):
+          results.append(m.check_int_message_list(a, 1))
+
+      threads = [threading.Thread(target=check) for _ in range(4)]
+      for thread in threads:
+        thread.start()
+      for thread in threads:
+        thread.join()
+      self.assertEqual(results, [32] * 80)
+    finally:
+      m.load_proto_vectors_in_parallel(batch_size=0, max_threads=0)
+
   def test_make_list(self):
     a = m.make_int_message_list(44)
     self.assertEqual(3, m.take_int_message_list(a, 44))
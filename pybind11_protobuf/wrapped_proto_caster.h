@@ -7,12 +7,14 @@
 #include <pybind11/pybind11.h>
 #include <pybind11/pytypes.h>
 
+#include <cstddef>
 #include <functional>
 #include <memory>
 #include <optional>
 #include <string>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 #include "google/protobuf/message.h"
 #include "absl/status/statusor.h"
@@ -65,6 +67,17 @@ namespace pybind11_protobuf {
 // is required to be called from a PYBIND11_MODULE definition before use.
 inline void ImportWrappedProtoCasters() { InitializePybindProtoCastUtil(); }
 
+// Loads std::vector<Proto> arguments of functions wrapped with
+// WithWrappedProtos on up to `max_threads` threads, serializing the python
+// protos with the GIL held and then parsing them, `batch_size` protos per
+// task, with the GIL released. Only sequences of at least two batches are
+// split. `max_threads` below 2, the default, loads on the calling thread.
+// Threads are started for each call, so batches should hold at least a few
+// hundred kilobytes of protos.
+inline void LoadProtoVectorsInParallel(size_t batch_size, int max_threads) {
+  SetParallelLoad(batch_size, max_threads);
+}
+
 /// Tag types for WrappedProto specialization.
 enum WrappedProtoKind : int { kConst, kValue, kMutable };
 
@@ -260,17 +273,24 @@ struct wrapped_proto_vector_caster {
     }
     auto s = pybind11::reinterpret_borrow<pybind11::sequence>(src);
     value.protos.clear();
+    if (pybind11_protobuf::UseParallelLoad(s.size())) {
+      value.protos.resize(s.size());
+      std::vector<::google::protobuf::Message*> messages;
+      messages.reserve(value.protos.size());
+      for (ProtoType& proto : value.protos) {
+        messages.push_back(&proto);
+      }
+      return pybind11_protobuf::PyProtoCopyToCProtosInParallel(
+          s, messages.data());
+    }
     value.protos.reserve(s.size());
     for (auto it : s) {
-      load_impl conv;
-      if (!conv.load(it, convert)) {
+      // Convert directly into the vector element rather than into a
+      // temporary heap-allocated message.
+      value.protos.emplace_back();
+      if (!load_impl::load_into(it, &value.protos.back())) {
         return false;
       }
-      if (conv.owned) {
-        value.protos.emplace_back(std::move(*conv.owned));
-      } else {
-        value.protos.emplace_back(*conv.value);
-      }
     }
     return true;
   }
@@ -279,20 +299,9 @@ struct wrapped_proto_vector_caster {
   static pybind11::handle cast(WrappedProtoVector<ProtoType> src,
                                pybind11::return_value_policy policy,
                                pybind11::handle parent) {
-    pybind11::list l(src.protos.size());
-    ssize_t index = 0;
-    for (auto&& value : src.protos) {
-      auto value_ = pybind11::reinterpret_steal<pybind11::object>(
-          pybind11_protobuf::native_cast_impl::cast_impl(
-              &value, pybind11::return_value_policy::move, parent,
-              /*is_const*/ false));
-      if (!value_) {
-        return pybind11::handle();
-      }
-      PyList_SET_ITEM(l.ptr(), index++,
-                      value_.release().ptr());  // steals a reference
-    }
-    return l.release();
+    // src is owned by the caster, so the elements may be moved.
+    return pybind11_protobuf::cast_proto_list<ProtoType>(src.protos,
+                                                         /*move=*/true);
   }
 
   explicit operator WrappedProtoVector<ProtoType>&&() && {